@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "AllocationCounter.h"
+
+#if defined(_DEBUG)
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> g_AllocationCount{};
+}
+
+// The array, nothrow and sized forms of the unaligned and the aligned allocations end up in these four.
+void* operator new(size_t size)
+{
+	g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* pMemory{ std::malloc(size > 0 ? size : 1) })
+	{
+		return pMemory;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+// Types over alignof(std::max_align_t), the alignas(64) per thread state of the FrameArena and the JobSystem.
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+	const size_t alignmentBytes{ static_cast<size_t>(alignment) };
+#if defined(_MSC_VER)
+	void* pMemory{ _aligned_malloc(size > 0 ? size : 1, alignmentBytes) };
+#else
+	// aligned_alloc wants a multiple of the alignment.
+	void* pMemory{ std::aligned_alloc(alignmentBytes, (std::max(size, size_t{ 1 }) + alignmentBytes - 1) / alignmentBytes * alignmentBytes) };
+#endif
+	if (pMemory)
+	{
+		return pMemory;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* pMemory, std::align_val_t) noexcept
+{
+#if defined(_MSC_VER)
+	_aligned_free(pMemory);
+#else
+	std::free(pMemory);
+#endif
+}
+#endif
+
+namespace dae
+{
+	uint64_t GetAllocationCount()
+	{
+#if defined(_DEBUG)
+		return g_AllocationCount.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+}
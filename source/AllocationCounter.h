@@ -0,0 +1,9 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	// Heap allocations of every thread since the program started. Debug builds replace the global operator new to count them,
+	// the other builds always return 0.
+	uint64_t GetAllocationCount();
+}
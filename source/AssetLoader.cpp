@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "AssetLoader.h"
+#include "Utils.h"
+
+namespace dae
+{
+	AssetLoader::AssetLoader(unsigned int workerCount)
+	{
+		// IMG_Init is not thread safe, so do it once here before the workers start decoding.
+		IMG_Init(IMG_INIT_PNG);
+
+		workerCount = std::max(1u, workerCount);
+		m_Workers.reserve(workerCount);
+		for (unsigned int i = 0; i < workerCount; ++i)
+		{
+			m_Workers.emplace_back(&AssetLoader::WorkerLoop, this);
+		}
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_TaskMutex);
+			m_IsStopping = true;
+		}
+		m_TaskCondition.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	template<typename T>
+	std::future<T> AssetLoader::Submit(const std::string& path, std::function<T()> load)
+	{
+		// std::function needs a copyable target, packaged_task is move only.
+		auto pTask = std::make_shared<std::packaged_task<T()>>([this, path, load]()
+		{
+			const uint64_t startCounter{ SDL_GetPerformanceCounter() };
+			T result{ load() };
+			AddTiming(path, startCounter);
+			return result;
+		});
+
+		std::future<T> future{ pTask->get_future() };
+		{
+			std::unique_lock<std::mutex> lock(m_TaskMutex);
+			m_Tasks.emplace([pTask]() { (*pTask)(); });
+		}
+		m_TaskCondition.notify_one();
+
+		return future;
+	}
+
+	std::future<SDL_Surface*> AssetLoader::LoadSurface(const std::string& path)
+	{
+		return Submit<SDL_Surface*>(path, [path]()
+		{
+			SDL_Surface* pSurface{ IMG_Load(path.c_str()) };
+			if (!pSurface)
+			{
+				std::cout << "AssetLoader: Failed to load " << path << ": " << IMG_GetError() << '\n';
+			}
+			return pSurface;
+		});
+	}
+
+	std::future<MeshData> AssetLoader::LoadMesh(const std::string& path)
+	{
+		return Submit<MeshData>(path, [path]()
+		{
+			MeshData data{};
+			if (!Utils::ParseOBJ(path, data.vertices, data.indices))
+			{
+				std::cout << "AssetLoader: Failed to load " << path << '\n';
+			}
+			return data;
+		});
+	}
+
+	void AssetLoader::PrintTimings() const
+	{
+		std::unique_lock<std::mutex> lock(m_TimingMutex);
+
+		float total{};
+		std::cout << "[Asset Load Timings]\n";
+		for (const auto& timing : m_Timings)
+		{
+			std::cout << timing.path << ": " << timing.milliseconds << " ms\n";
+			total += timing.milliseconds;
+		}
+		std::cout << "Total (summed over " << m_Workers.size() << " workers): " << total << " ms\n\n";
+	}
+
+	void AssetLoader::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task{};
+			{
+				std::unique_lock<std::mutex> lock(m_TaskMutex);
+				m_TaskCondition.wait(lock, [this]() { return m_IsStopping || !m_Tasks.empty(); });
+
+				if (m_Tasks.empty())
+				{
+					return;
+				}
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+
+	void AssetLoader::AddTiming(const std::string& path, uint64_t startCounter)
+	{
+		const uint64_t elapsedCounts{ SDL_GetPerformanceCounter() - startCounter };
+		const float milliseconds{ static_cast<float>(elapsedCounts) * 1000.f / static_cast<float>(SDL_GetPerformanceFrequency()) };
+
+		std::unique_lock<std::mutex> lock(m_TimingMutex);
+		m_Timings.push_back({ path, milliseconds });
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <queue>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "Vertex.h"
+
+struct SDL_Surface;
+
+namespace dae
+{
+	struct MeshData
+	{
+		std::vector<Vertex_In> vertices{};
+		std::vector<uint32_t> indices{};
+	};
+
+	// Decodes images and parses meshes on a small pool of worker threads.
+	// Every Load call returns immediately with a future, so the caller can keep doing
+	// other work (like creating the DirectX device) while the assets are loading.
+	class AssetLoader final
+	{
+	public:
+
+		explicit AssetLoader(unsigned int workerCount = std::thread::hardware_concurrency());
+		~AssetLoader();
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader(AssetLoader&&) noexcept = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+		AssetLoader& operator=(AssetLoader&&) noexcept = delete;
+
+		std::future<SDL_Surface*> LoadSurface(const std::string& path);
+		std::future<MeshData> LoadMesh(const std::string& path);
+
+		void PrintTimings() const;
+
+	private:
+
+		struct LoadTiming
+		{
+			std::string path{};
+			float milliseconds{};
+		};
+
+		std::vector<std::thread> m_Workers{};
+		std::queue<std::function<void()>> m_Tasks{};
+		std::mutex m_TaskMutex{};
+		std::condition_variable m_TaskCondition{};
+		bool m_IsStopping{ false };
+
+		std::vector<LoadTiming> m_Timings{};
+		mutable std::mutex m_TimingMutex{};
+
+		// Functions.
+
+		template<typename T>
+		std::future<T> Submit(const std::string& path, std::function<T()> load);
+
+		void WorkerLoop();
+		void AddTiming(const std::string& path, uint64_t startCounter);
+	};
+}
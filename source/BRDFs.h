@@ -25,6 +25,19 @@ namespace dae
 			return lambert;
 		}
 
+		/**
+		 * \param l Incoming (incident) Light Direction
+		 * \param v View Direction
+		 * \param n Normal of the Surface
+		 * \return Cosine between the reflected light and the view direction, clamped to 0
+		 */
+		static float PhongCosine(const Vector3& l, const Vector3& v, const Vector3& n)
+		{
+			const Vector3 reflect{ Vector3::Reflect(l, n) };
+			//Vector3 reflect{ l - (2 * (Vector3::Dot(n, l)) * n)};
+			return std::max(0.f, Vector3::Dot(reflect, v));
+		}
+
 		/**
 		 * \param specularColor
 		 * \param ks Specular Reflection Coefficient
@@ -36,9 +49,7 @@ namespace dae
 		 */
 		static ColorRGB Phong(const ColorRGB& specularColor, float ks, float exp, const Vector3& l, const Vector3& v, const Vector3& n)
 		{
-			const Vector3 reflect{ Vector3::Reflect(l, n) };
-			//Vector3 reflect{ l - (2 * (Vector3::Dot(n, l)) * n)};
-			const float cosAlpha{ std::max(0.f, Vector3::Dot(reflect, v)) };
+			const float cosAlpha{ PhongCosine(l, v, n) };
 			const float phong{ ks * (pow(cosAlpha, exp)) };
 			return specularColor * phong;
 		}
@@ -0,0 +1,227 @@
+#include "pch.h"
+#include "ClusteredLights.h"
+
+#include <array>
+#include <string>
+#include <numeric>
+
+namespace dae
+{
+	void LightBuffer::Clear()
+	{
+		types.clear();
+		positionX.clear();
+		positionY.clear();
+		positionZ.clear();
+		directionX.clear();
+		directionY.clear();
+		directionZ.clear();
+		ranges.clear();
+		innerConeCos.clear();
+		outerConeCos.clear();
+		intensities.clear();
+	}
+
+	void LightBuffer::Add(const Lights& light)
+	{
+		const Vector3 position{ light.GetPosition() };
+		const Vector3 direction{ light.GetDirection() };
+
+		types.emplace_back(light.GetType());
+		positionX.emplace_back(position.x);
+		positionY.emplace_back(position.y);
+		positionZ.emplace_back(position.z);
+		directionX.emplace_back(direction.x);
+		directionY.emplace_back(direction.y);
+		directionZ.emplace_back(direction.z);
+		ranges.emplace_back(light.GetRange());
+		innerConeCos.emplace_back(light.GetInnerConeCos());
+		outerConeCos.emplace_back(light.GetOuterConeCos());
+		intensities.emplace_back(light.GetlightIntensity());
+	}
+
+	ClusteredLights::ClusteredLights(int width, int height)
+		: m_Width(width)
+		, m_Height(height)
+		, m_TilesX((width + TileSize - 1) / TileSize)
+		, m_TilesY((height + TileSize - 1) / TileSize)
+	{
+		m_Clusters.resize(static_cast<size_t>(m_TilesX) * m_TilesY * SliceCount);
+		m_ShadedPixels = std::make_unique<std::atomic<uint32_t>[]>(m_Clusters.size());
+	}
+
+	void ClusteredLights::SetViewport(int width, int height)
+	{
+		m_Width = width;
+		m_Height = height;
+		m_TilesX = (width + TileSize - 1) / TileSize;
+		m_TilesY = (height + TileSize - 1) / TileSize;
+		assert(GetClusterCount() <= m_Clusters.size() && "The viewport is larger than the clusters were allocated for.");
+	}
+
+	void ClusteredLights::Build(const std::vector<Lights*>& pLights, const Camera& camera)
+	{
+		m_TanHalfFov = camera.fov;
+		m_AspectRatio = camera.aspectRatio;
+		m_NearPlane = camera.nearPlane;
+		m_FarPlane = camera.farPlane;
+		m_SliceScale = static_cast<float>(SliceCount) / std::log(m_FarPlane / m_NearPlane);
+		m_SliceBias = -std::log(m_NearPlane) * m_SliceScale;
+
+		m_Lights.Clear();
+		for (const Lights* pLight : pLights)
+		{
+			m_Lights.Add(*pLight);
+		}
+
+		for (size_t cluster = 0; cluster < GetClusterCount(); ++cluster)
+		{
+			m_Clusters[cluster].clear();
+			m_ShadedPixels[cluster].store(0, std::memory_order_relaxed);
+		}
+
+		for (uint32_t lightIndex = 0; lightIndex < static_cast<uint32_t>(m_Lights.GetCount()); ++lightIndex)
+		{
+			const float radius{ m_Lights.ranges[lightIndex] };
+			if (radius == FLT_MAX)
+			{
+				for (size_t cluster = 0; cluster < GetClusterCount(); ++cluster)
+				{
+					m_Clusters[cluster].emplace_back(lightIndex);
+				}
+				continue;
+			}
+
+			const Vector3 center{ camera.viewMatrix.TransformPoint(Vector3{ m_Lights.positionX[lightIndex], m_Lights.positionY[lightIndex], m_Lights.positionZ[lightIndex] }) };
+			const float nearestDepth{ std::max(center.z - radius, m_NearPlane) };
+			const float farthestDepth{ std::min(center.z + radius, m_FarPlane) };
+			if (nearestDepth > farthestDepth)
+			{
+				continue;
+			}
+
+			// Conservative screen bounds of the sphere: x / z over the box around it is extreme at its corners.
+			// A sphere reaching behind the near plane can cover the whole screen.
+			int firstTileX{ 0 }, lastTileX{ m_TilesX - 1 };
+			int firstTileY{ 0 }, lastTileY{ m_TilesY - 1 };
+			if (center.z - radius > m_NearPlane)
+			{
+				const float xScale{ 1.f / (m_TanHalfFov * m_AspectRatio) };
+				const float yScale{ 1.f / m_TanHalfFov };
+				const float minNdcX{ std::min((center.x - radius) / nearestDepth, (center.x - radius) / farthestDepth) * xScale };
+				const float maxNdcX{ std::max((center.x + radius) / nearestDepth, (center.x + radius) / farthestDepth) * xScale };
+				const float minNdcY{ std::min((center.y - radius) / nearestDepth, (center.y - radius) / farthestDepth) * yScale };
+				const float maxNdcY{ std::max((center.y + radius) / nearestDepth, (center.y + radius) / farthestDepth) * yScale };
+				if (minNdcX > 1.f || maxNdcX < -1.f || minNdcY > 1.f || maxNdcY < -1.f)
+				{
+					continue;
+				}
+
+				// NDC y points up, raster y down.
+				firstTileX = std::clamp(static_cast<int>((minNdcX + 1.f) * 0.5f * static_cast<float>(m_Width)) / TileSize, 0, m_TilesX - 1);
+				lastTileX = std::clamp(static_cast<int>((maxNdcX + 1.f) * 0.5f * static_cast<float>(m_Width)) / TileSize, 0, m_TilesX - 1);
+				firstTileY = std::clamp(static_cast<int>((1.f - maxNdcY) * 0.5f * static_cast<float>(m_Height)) / TileSize, 0, m_TilesY - 1);
+				lastTileY = std::clamp(static_cast<int>((1.f - minNdcY) * 0.5f * static_cast<float>(m_Height)) / TileSize, 0, m_TilesY - 1);
+			}
+
+			const int firstSlice{ GetSlice(nearestDepth) };
+			const int lastSlice{ GetSlice(farthestDepth) };
+
+			for (int slice = firstSlice; slice <= lastSlice; ++slice)
+			{
+				for (int tileY = firstTileY; tileY <= lastTileY; ++tileY)
+				{
+					for (int tileX = firstTileX; tileX <= lastTileX; ++tileX)
+					{
+						if (IsSphereInCluster(center, radius, tileX, tileY, slice))
+						{
+							m_Clusters[GetClusterIndex(tileX, tileY, slice)].emplace_back(lightIndex);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void ClusteredLights::PrintStats() const
+	{
+		size_t maxLights{};
+		size_t totalLights{};
+		size_t occupiedClusters{};
+		uint64_t shadedPixels{};
+		uint64_t lightEvaluations{};
+		std::vector<uint64_t> evaluationsPerLight(m_Lights.GetCount());
+
+		for (size_t cluster = 0; cluster < GetClusterCount(); ++cluster)
+		{
+			const auto& lights{ m_Clusters[cluster] };
+			maxLights = std::max(maxLights, lights.size());
+			totalLights += lights.size();
+			occupiedClusters += lights.empty() ? 0 : 1;
+
+			const uint32_t pixels{ m_ShadedPixels[cluster].load(std::memory_order_relaxed) };
+			shadedPixels += pixels;
+			lightEvaluations += static_cast<uint64_t>(pixels) * lights.size();
+			for (const uint32_t lightIndex : lights)
+			{
+				evaluationsPerLight[lightIndex] += pixels;
+			}
+		}
+
+		std::cout << "Lights: " << m_Lights.GetCount()
+			<< " | Clusters: " << GetClusterCount() << " (" << occupiedClusters << " lit)"
+			<< " | Max lights per cluster: " << maxLights
+			<< " | Avg lights per lit cluster: " << (occupiedClusters ? static_cast<float>(totalLights) / static_cast<float>(occupiedClusters) : 0.f) << '\n';
+
+		std::cout << "Shaded pixels: " << shadedPixels
+			<< " | Light evaluations: " << lightEvaluations
+			<< " | Avg lights per pixel: " << (shadedPixels ? static_cast<float>(lightEvaluations) / static_cast<float>(shadedPixels) : 0.f) << '\n';
+
+		// The most expensive lights.
+		constexpr size_t printedLights{ 5 };
+		std::vector<uint32_t> lightOrder(evaluationsPerLight.size());
+		std::iota(lightOrder.begin(), lightOrder.end(), 0);
+		const auto printedEnd{ lightOrder.begin() + std::min(printedLights, lightOrder.size()) };
+		std::partial_sort(lightOrder.begin(), printedEnd, lightOrder.end(), [&](uint32_t a, uint32_t b) { return evaluationsPerLight[a] > evaluationsPerLight[b]; });
+
+		const std::array<std::string, 3> typeNames{ "Directional", "Point", "Spot" };
+		for (auto it = lightOrder.begin(); it != printedEnd; ++it)
+		{
+			std::cout << "  Light " << *it << " (" << typeNames[static_cast<int>(m_Lights.types[*it])] << "): "
+				<< evaluationsPerLight[*it] << " evaluations\n";
+		}
+	}
+
+	float ClusteredLights::GetSliceDepth(int slice) const
+	{
+		return m_NearPlane * std::pow(m_FarPlane / m_NearPlane, static_cast<float>(slice) / static_cast<float>(SliceCount));
+	}
+
+	bool ClusteredLights::IsSphereInCluster(const Vector3& center, float radius, int tileX, int tileY, int slice) const
+	{
+		// Tile bounds in NDC.
+		const float minNdcX{ static_cast<float>(tileX * TileSize) / static_cast<float>(m_Width) * 2.f - 1.f };
+		const float maxNdcX{ static_cast<float>(std::min((tileX + 1) * TileSize, m_Width)) / static_cast<float>(m_Width) * 2.f - 1.f };
+		const float minNdcY{ 1.f - static_cast<float>(std::min((tileY + 1) * TileSize, m_Height)) / static_cast<float>(m_Height) * 2.f };
+		const float maxNdcY{ 1.f - static_cast<float>(tileY * TileSize) / static_cast<float>(m_Height) * 2.f };
+
+		// View space box around the frustum segment, its x and y grow with the depth.
+		const float nearDepth{ GetSliceDepth(slice) };
+		const float farDepth{ GetSliceDepth(slice + 1) };
+		const float xExtent{ m_TanHalfFov * m_AspectRatio };
+		const float yExtent{ m_TanHalfFov };
+
+		const Vector3 boxMin{
+			std::min(minNdcX * nearDepth, minNdcX * farDepth) * xExtent,
+			std::min(minNdcY * nearDepth, minNdcY * farDepth) * yExtent,
+			nearDepth };
+		const Vector3 boxMax{
+			std::max(maxNdcX * nearDepth, maxNdcX * farDepth) * xExtent,
+			std::max(maxNdcY * nearDepth, maxNdcY * farDepth) * yExtent,
+			farDepth };
+
+		// Distance from the sphere center to the closest point of the box.
+		const Vector3 closest{ Vector3::Max(boxMin, Vector3::Min(boxMax, center)) };
+		return (closest - center).SqrMagnitude() <= radius * radius;
+	}
+}
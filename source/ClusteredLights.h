@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <memory>
+#include "Camera.h"
+#include "Lights.h"
+
+namespace dae
+{
+	// Every light of a frame as flat arrays, so the pixels read plain floats instead of calling virtual getters.
+	struct LightBuffer
+	{
+		std::vector<LightType> types{};
+		std::vector<float> positionX{};
+		std::vector<float> positionY{};
+		std::vector<float> positionZ{};
+		std::vector<float> directionX{};
+		std::vector<float> directionY{};
+		std::vector<float> directionZ{};
+		std::vector<float> ranges{};
+		std::vector<float> innerConeCos{};
+		std::vector<float> outerConeCos{};
+		std::vector<float> intensities{};
+
+		size_t GetCount() const { return types.size(); }
+		void Clear();
+		void Add(const Lights& light);
+	};
+
+	// Bins the lights into froxels: screen tiles split into exponential depth slices of the view frustum.
+	// A cluster keeps only the lights whose range sphere overlaps its bounds, lights without a range are in every cluster.
+	// The clusters cover the whole frustum, so no depth prepass is needed to bin them.
+	class ClusteredLights final
+	{
+	public:
+
+		static constexpr int TileSize{ 32 };
+		static constexpr int SliceCount{ 16 };
+
+		// The clusters are allocated for this size, the viewport can shrink below it without reallocating.
+		ClusteredLights(int width, int height);
+
+		// Size of the raster the pixels come from, at most the constructed size.
+		void SetViewport(int width, int height);
+
+		// Snapshots the lights and rebuilds the clusters, once per frame before rasterizing.
+		void Build(const std::vector<Lights*>& pLights, const Camera& camera);
+
+		const LightBuffer& GetLights() const { return m_Lights; }
+
+		// Cluster of a pixel, viewDepth is the view space z (the clip space w).
+		int FindCluster(int px, int py, float viewDepth) const { return GetClusterIndex(px / TileSize, py / TileSize, GetSlice(viewDepth)); }
+
+		// Indices into GetLights() of every light that can reach the cluster.
+		const std::vector<uint32_t>& GetClusterLights(int cluster) const { return m_Clusters[cluster]; }
+
+		// Cost counters: a shaded pixel evaluates every light of its cluster,
+		// so counting the pixels per cluster is enough to know what every light costs.
+		// Only while the stats are printed, otherwise every worker would contend on the counters for nothing.
+		void SetCountingPixels(bool isCounting) { m_IsCountingPixels = isCounting; }
+		void CountShadedPixel(int cluster) const
+		{
+			if (m_IsCountingPixels)
+			{
+				m_ShadedPixels[cluster].fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// Light count, cluster occupancy and the light cost of the last frame.
+		void PrintStats() const;
+
+	private:
+
+		int m_Width{};
+		int m_Height{};
+		int m_TilesX{};
+		int m_TilesY{};
+
+		// Camera of the last Build.
+		float m_TanHalfFov{};
+		float m_AspectRatio{};
+		float m_NearPlane{};
+		float m_FarPlane{};
+		// slice = log(viewDepth) * scale + bias.
+		float m_SliceScale{};
+		float m_SliceBias{};
+
+		LightBuffer m_Lights{};
+		std::vector<std::vector<uint32_t>> m_Clusters{};
+		std::unique_ptr<std::atomic<uint32_t>[]> m_ShadedPixels{};
+		bool m_IsCountingPixels{ false };
+
+		// Functions.
+
+		int GetClusterIndex(int tileX, int tileY, int slice) const { return (slice * m_TilesY + tileY) * m_TilesX + tileX; }
+		// Clusters of the viewport, a prefix of m_Clusters.
+		size_t GetClusterCount() const { return static_cast<size_t>(m_TilesX) * m_TilesY * SliceCount; }
+		float GetSliceDepth(int slice) const;
+		int GetSlice(float viewDepth) const { return std::clamp(static_cast<int>(std::log(viewDepth) * m_SliceScale + m_SliceBias), 0, SliceCount - 1); }
+		bool IsSphereInCluster(const Vector3& center, float radius, int tileX, int tileY, int slice) const;
+	};
+}
@@ -0,0 +1,217 @@
+#include "pch.h"
+#include "ColorBuffer.h"
+
+#include <emmintrin.h> // SSE2
+
+namespace dae
+{
+	namespace
+	{
+		// Four pixels: scaled down by their largest channel when it is over 1 like ColorRGB::MaxToOne, then truncated to 8 bits like static_cast<uint8_t>.
+		__m128i PackPixels(const float* pRed, const float* pGreen, const float* pBlue, __m128i redShift, __m128i greenShift, __m128i blueShift, __m128i alpha)
+		{
+			const __m128 zero{ _mm_setzero_ps() };
+			const __m128 one{ _mm_set1_ps(1.f) };
+			const __m128 scale{ _mm_set1_ps(255.f) };
+
+			const __m128 red{ _mm_max_ps(_mm_loadu_ps(pRed), zero) };
+			const __m128 green{ _mm_max_ps(_mm_loadu_ps(pGreen), zero) };
+			const __m128 blue{ _mm_max_ps(_mm_loadu_ps(pBlue), zero) };
+
+			const __m128 maxValue{ _mm_max_ps(_mm_max_ps(red, _mm_max_ps(green, blue)), one) };
+
+			const __m128i red8{ _mm_cvttps_epi32(_mm_mul_ps(_mm_div_ps(red, maxValue), scale)) };
+			const __m128i green8{ _mm_cvttps_epi32(_mm_mul_ps(_mm_div_ps(green, maxValue), scale)) };
+			const __m128i blue8{ _mm_cvttps_epi32(_mm_mul_ps(_mm_div_ps(blue, maxValue), scale)) };
+
+			return _mm_or_si128(_mm_or_si128(_mm_sll_epi32(red8, redShift), _mm_sll_epi32(green8, greenShift)),
+				_mm_or_si128(_mm_sll_epi32(blue8, blueShift), alpha));
+		}
+
+		// One pixel like PackPixels.
+		uint32_t PackColor(const ColorRGB& linearColor, const PixelFormat& format)
+		{
+			ColorRGB color{ std::max(linearColor.r, 0.f), std::max(linearColor.g, 0.f), std::max(linearColor.b, 0.f) };
+			color.MaxToOne();
+
+			return (static_cast<uint32_t>(static_cast<uint8_t>(color.r * 255)) << format.redShift)
+				| (static_cast<uint32_t>(static_cast<uint8_t>(color.g * 255)) << format.greenShift)
+				| (static_cast<uint32_t>(static_cast<uint8_t>(color.b * 255)) << format.blueShift)
+				| format.alphaMask;
+		}
+
+		// PackPixels over a row of count pixels.
+		void PackRow(const float* pRed, const float* pGreen, const float* pBlue, int count, uint32_t* pRow, const PixelFormat& format)
+		{
+			const __m128i redShift{ _mm_cvtsi32_si128(format.redShift) };
+			const __m128i greenShift{ _mm_cvtsi32_si128(format.greenShift) };
+			const __m128i blueShift{ _mm_cvtsi32_si128(format.blueShift) };
+			const __m128i alpha{ _mm_set1_epi32(static_cast<int>(format.alphaMask)) };
+
+			int px{};
+			for (; px + 8 <= count; px += 8)
+			{
+				const __m128i low{ PackPixels(pRed + px, pGreen + px, pBlue + px, redShift, greenShift, blueShift, alpha) };
+				const __m128i high{ PackPixels(pRed + px + 4, pGreen + px + 4, pBlue + px + 4, redShift, greenShift, blueShift, alpha) };
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pRow + px), low);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pRow + px + 4), high);
+			}
+
+			// Tiles cut off by the screen edge can end in the middle of 8 pixels.
+			for (; px < count; ++px)
+			{
+				pRow[px] = PackColor(ColorRGB{ pRed[px], pGreen[px], pBlue[px] }, format);
+			}
+		}
+
+		// Pixel centers line up: target pixel t samples the source at (t + 0.5) * source / target - 0.5, clamped to the edge.
+		void GetBilinearTap(int target, int sourceSize, int targetSize, int& first, int& second, float& weight)
+		{
+			const float position{ std::max((static_cast<float>(target) + 0.5f) * static_cast<float>(sourceSize) / static_cast<float>(targetSize) - 0.5f, 0.f) };
+			first = std::min(static_cast<int>(position), sourceSize - 1);
+			second = std::min(first + 1, sourceSize - 1);
+			weight = position - static_cast<float>(first);
+		}
+	}
+
+	PixelFormat PixelFormat::FromSurfaceFormat(const SDL_PixelFormat& format)
+	{
+		assert(format.BytesPerPixel == 4 && "The software rasterizer only writes 32 bit surfaces.");
+		return PixelFormat{ format.Rshift, format.Gshift, format.Bshift, format.Amask };
+	}
+
+	ColorBuffer::ColorBuffer(int width, int height)
+	{
+		Resize(width, height);
+	}
+
+	void ColorBuffer::Resize(int width, int height)
+	{
+		m_Width = width;
+		m_Height = height;
+		m_Stride = GetPaddedStride(width);
+
+		// Swapped with fresh vectors, so shrinking gives the memory back too.
+		const size_t pixelCount{ static_cast<size_t>(m_Stride) * height };
+		std::vector<float>(pixelCount).swap(m_Red);
+		std::vector<float>(pixelCount).swap(m_Green);
+		std::vector<float>(pixelCount).swap(m_Blue);
+	}
+
+	void ColorBuffer::Clear(const Tile& tile, const ColorRGB& color)
+	{
+		const int width{ tile.maxX - tile.minX };
+		for (int py = tile.minY; py < tile.maxY; ++py)
+		{
+			const int index{ py * m_Stride + tile.minX };
+			std::fill_n(&m_Red[index], width, color.r);
+			std::fill_n(&m_Green[index], width, color.g);
+			std::fill_n(&m_Blue[index], width, color.b);
+		}
+	}
+
+	void ColorBuffer::ResolveClear(const Tile& tile, const ColorRGB& color, uint32_t* pPixels, int pixelsPerRow, const PixelFormat& format) const
+	{
+		const uint32_t pixel{ PackColor(color, format) };
+		for (int py = tile.minY; py < tile.maxY; ++py)
+		{
+			std::fill_n(pPixels + py * pixelsPerRow + tile.minX, tile.maxX - tile.minX, pixel);
+		}
+	}
+
+	void ColorBuffer::Resolve(const Tile& tile, uint32_t* pPixels, int pixelsPerRow, const PixelFormat& format) const
+	{
+		for (int py = tile.minY; py < tile.maxY; ++py)
+		{
+			const int index{ py * m_Stride + tile.minX };
+			PackRow(&m_Red[index], &m_Green[index], &m_Blue[index], tile.maxX - tile.minX, pPixels + py * pixelsPerRow + tile.minX, format);
+		}
+	}
+
+	void ColorBuffer::ResolveUpscaled(int sourceWidth, int sourceHeight, int targetWidth, int targetHeight, int minY, int maxY, uint32_t* pPixels, int pixelsPerRow, const PixelFormat& format) const
+	{
+		assert(sourceWidth <= m_Width && sourceHeight <= m_Height && "The source is larger than the color buffer.");
+
+		// Filtered before the tonemap, like a hardware resolve of the float target would.
+		// The column taps are the same for every row, the vertical blend runs over whole source rows.
+		thread_local std::vector<int> firstColumns{}, secondColumns{};
+		thread_local std::vector<float> columnWeights{};
+		thread_local std::vector<float> blendedRed{}, blendedGreen{}, blendedBlue{};
+		thread_local std::vector<float> rowRed{}, rowGreen{}, rowBlue{};
+		firstColumns.resize(targetWidth);
+		secondColumns.resize(targetWidth);
+		columnWeights.resize(targetWidth);
+		blendedRed.resize(sourceWidth);
+		blendedGreen.resize(sourceWidth);
+		blendedBlue.resize(sourceWidth);
+		rowRed.resize(targetWidth);
+		rowGreen.resize(targetWidth);
+		rowBlue.resize(targetWidth);
+
+		for (int px = 0; px < targetWidth; ++px)
+		{
+			GetBilinearTap(px, sourceWidth, targetWidth, firstColumns[px], secondColumns[px], columnWeights[px]);
+		}
+
+		for (int py = minY; py < maxY; ++py)
+		{
+			int firstRow{}, secondRow{};
+			float rowWeight{};
+			GetBilinearTap(py, sourceHeight, targetHeight, firstRow, secondRow, rowWeight);
+
+			const float* pFirstRed{ &m_Red[firstRow * m_Stride] };
+			const float* pFirstGreen{ &m_Green[firstRow * m_Stride] };
+			const float* pFirstBlue{ &m_Blue[firstRow * m_Stride] };
+			const float* pSecondRed{ &m_Red[secondRow * m_Stride] };
+			const float* pSecondGreen{ &m_Green[secondRow * m_Stride] };
+			const float* pSecondBlue{ &m_Blue[secondRow * m_Stride] };
+			for (int sx = 0; sx < sourceWidth; ++sx)
+			{
+				blendedRed[sx] = pFirstRed[sx] + (pSecondRed[sx] - pFirstRed[sx]) * rowWeight;
+				blendedGreen[sx] = pFirstGreen[sx] + (pSecondGreen[sx] - pFirstGreen[sx]) * rowWeight;
+				blendedBlue[sx] = pFirstBlue[sx] + (pSecondBlue[sx] - pFirstBlue[sx]) * rowWeight;
+			}
+
+			for (int px = 0; px < targetWidth; ++px)
+			{
+				const int first{ firstColumns[px] };
+				const int second{ secondColumns[px] };
+				const float weight{ columnWeights[px] };
+				rowRed[px] = blendedRed[first] + (blendedRed[second] - blendedRed[first]) * weight;
+				rowGreen[px] = blendedGreen[first] + (blendedGreen[second] - blendedGreen[first]) * weight;
+				rowBlue[px] = blendedBlue[first] + (blendedBlue[second] - blendedBlue[first]) * weight;
+			}
+
+			PackRow(rowRed.data(), rowGreen.data(), rowBlue.data(), targetWidth, pPixels + py * pixelsPerRow, format);
+		}
+	}
+
+	float ColorBuffer::GetLuminanceGradient(const Tile& tile) const
+	{
+		const auto luminance = [this](int index)
+		{
+			return 0.2126f * std::min(m_Red[index], 1.f) + 0.7152f * std::min(m_Green[index], 1.f) + 0.0722f * std::min(m_Blue[index], 1.f);
+		};
+
+		// The last row and column have their neighbour in the next tile, or none at the screen edge.
+		const int maxX{ std::min(tile.maxX, m_Width - 1) };
+		const int maxY{ std::min(tile.maxY, m_Height - 1) };
+		if (maxX <= tile.minX || maxY <= tile.minY)
+		{
+			return 0.f;
+		}
+
+		float gradient{};
+		for (int py = tile.minY; py < maxY; ++py)
+		{
+			for (int px = tile.minX; px < maxX; ++px)
+			{
+				const int index{ py * m_Stride + px };
+				const float center{ luminance(index) };
+				gradient += std::abs(luminance(index + 1) - center) + std::abs(luminance(index + m_Stride) - center);
+			}
+		}
+
+		return gradient / static_cast<float>((maxX - tile.minX) * (maxY - tile.minY));
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include "ColorRGB.h"
+#include "TileBinner.h"
+
+struct SDL_PixelFormat;
+
+namespace dae
+{
+	// Channel positions of a 32 bit surface format, looked up once instead of going through SDL_MapRGB per pixel.
+	struct PixelFormat
+	{
+		int redShift{};
+		int greenShift{};
+		int blueShift{};
+		// Set to opaque in every packed pixel, 0 for formats without alpha.
+		uint32_t alphaMask{};
+
+		static PixelFormat FromSurfaceFormat(const SDL_PixelFormat& format);
+	};
+
+	// Float color target of the software rasterizer, one plane per channel so a resolve converts 8 pixels with a few SSE instructions.
+	// Pixels are written unclamped, the resolve tonemaps them into the packed surface.
+	class ColorBuffer final
+	{
+	public:
+
+		// Rows are padded to a multiple of this many pixels, so every row starts on a cache line offset and a multiple of 4 floats.
+		static constexpr int StrideAlignment{ 16 };
+
+		ColorBuffer(int width, int height);
+
+		// Reallocates the planes, only on a resize of the window.
+		void Resize(int width, int height);
+
+		// Pixels per row, the index of a pixel is py * GetStride() + px.
+		int GetStride() const { return m_Stride; }
+		static int GetPaddedStride(int width) { return (width + StrideAlignment - 1) / StrideAlignment * StrideAlignment; }
+
+		void Write(int index, const ColorRGB& color)
+		{
+			m_Red[index] = color.r;
+			m_Green[index] = color.g;
+			m_Blue[index] = color.b;
+		}
+
+		ColorRGB Read(int index) const
+		{
+			return ColorRGB{ m_Red[index], m_Green[index], m_Blue[index] };
+		}
+
+		void Clear(const Tile& tile, const ColorRGB& color);
+
+		// MaxToOne, float to 8 bit and packing of the tile's pixels, 8 at a time.
+		void Resolve(const Tile& tile, uint32_t* pPixels, int pixelsPerRow, const PixelFormat& format) const;
+
+		// Resolve of a tile nothing was drawn into: the packed color is written without reading the planes.
+		void ResolveClear(const Tile& tile, const ColorRGB& color, uint32_t* pPixels, int pixelsPerRow, const PixelFormat& format) const;
+
+		// Resolve of a raster smaller than the surface: the top left sourceWidth by sourceHeight pixels are bilinearly scaled up
+		// to targetWidth by targetHeight, only the surface rows minY up to maxY are written.
+		void ResolveUpscaled(int sourceWidth, int sourceHeight, int targetWidth, int targetHeight, int minY, int maxY, uint32_t* pPixels, int pixelsPerRow, const PixelFormat& format) const;
+
+		// Mean luminance difference to the right and lower neighbour over the tile, low for flat content.
+		float GetLuminanceGradient(const Tile& tile) const;
+
+	private:
+
+		int m_Width{};
+		int m_Height{};
+		int m_Stride{};
+
+		std::vector<float> m_Red{};
+		std::vector<float> m_Green{};
+		std::vector<float> m_Blue{};
+	};
+}
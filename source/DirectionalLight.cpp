@@ -10,6 +10,11 @@ namespace dae
 	{
 	}
 
+	LightType DirectionalLight::GetType() const
+	{
+		return LightType::Directional;
+	}
+
 	Vector3 DirectionalLight::GetDirection() const
 	{
 		return m_Direction;
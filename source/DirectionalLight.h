@@ -7,13 +7,14 @@ namespace dae
 	{
 	public:
 		DirectionalLight(const Vector3& direction, float lightIntensity);
-		~DirectionalLight() = default;
+		~DirectionalLight() override = default;
 
 		DirectionalLight(const DirectionalLight&) = default;
 		DirectionalLight(DirectionalLight&&) noexcept = default;
 		DirectionalLight& operator=(const DirectionalLight&) = default;
 		DirectionalLight& operator=(DirectionalLight&&) noexcept = default;
 
+		virtual LightType GetType() const override;
 		virtual Vector3 GetDirection() const override;
 		virtual float GetlightIntensity() const override;
 
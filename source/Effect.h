@@ -32,7 +32,8 @@ namespace dae
 		virtual void SetSpecularMap(Texture* pSpecularTexture) = 0;
 		virtual void SetGlossMap(Texture* pGlossTexture) = 0;
 
-		virtual void SetLight(Lights* pLight) = 0;
+		// The lights that reach the mesh, effects that are not lit ignore them.
+		virtual void SetLights(const std::vector<Lights*>& pLights) = 0;
 
 		void CycleFilteringMode();
 
@@ -20,7 +20,7 @@ namespace dae
 		void SetSpecularMap(Texture* pSpecularTexture) override {}
 		void SetGlossMap(Texture* pGlossTexture) override {}
 
-		void SetLight(Lights* pLight) override {}
+		void SetLights(const std::vector<Lights*>& pLights) override {}
 
 	private:
 
@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "FireSoftwareEffect.h"
+
+#include "Sampler.h"
+#include "SoftwareRaster.h"
+
+namespace dae
+{
+	// The fire is drawn with the point sampler of FireShader.fx.
+	using FireSampler = Sampler<AddressMode::Wrap, FilterMode::Point>;
+
+	void FireSoftwareEffect::BeginFrame(const RasterState& state)
+	{
+		switch (state.cullMode)
+		{
+		case Culling::None:
+			m_pDrawTile = GetDrawTile<Culling::None>(state.depthFormat);
+			break;
+		case Culling::Front:
+			m_pDrawTile = GetDrawTile<Culling::Front>(state.depthFormat);
+			break;
+		default:
+			m_pDrawTile = GetDrawTile<Culling::Back>(state.depthFormat);
+			break;
+		}
+	}
+
+	template<Culling CullMode>
+	FireSoftwareEffect::DrawTileFunction FireSoftwareEffect::GetDrawTile(DepthFormat depthFormat)
+	{
+		switch (depthFormat)
+		{
+		case DepthFormat::ReversedFloat32:
+			return &FireSoftwareEffect::DrawTileWith<CullMode, DepthFormat::ReversedFloat32>;
+		case DepthFormat::Unorm24:
+			return &FireSoftwareEffect::DrawTileWith<CullMode, DepthFormat::Unorm24>;
+		case DepthFormat::Unorm16:
+			return &FireSoftwareEffect::DrawTileWith<CullMode, DepthFormat::Unorm16>;
+		default:
+			return &FireSoftwareEffect::DrawTileWith<CullMode, DepthFormat::Float32>;
+		}
+	}
+
+	void FireSoftwareEffect::TransformVertices(Mesh& mesh, const Camera& camera) const
+	{
+		SoftwareRaster::TransformVertices<SoftwareRaster::StandardVertexShader>(mesh, camera);
+	}
+
+	void FireSoftwareEffect::DrawTile(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const
+	{
+		(this->*m_pDrawTile)(state, triangles, tileTriangles, tile);
+	}
+
+	void FireSoftwareEffect::SetDiffuseMap(Texture* pDiffuseTexture)
+	{
+		m_pDiffuseFire = pDiffuseTexture;
+	}
+
+	template<Culling CullMode, DepthFormat Format>
+	void FireSoftwareEffect::DrawTileWith(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const
+	{
+		const PixelShader pixelShader{ *m_pDiffuseFire };
+		for (const uint32_t triangle : tileTriangles)
+		{
+			SoftwareRaster::RasterizeBlended<PixelShader, CullMode, Format>(state, triangles[triangle], tile, pixelShader);
+		}
+	}
+
+	ColorRGB FireSoftwareEffect::PixelShader::Shade(const Vertex_Out& pixel, float& alpha) const
+	{
+		alpha = FireSampler::SampleAlpha(diffuse, pixel.uv);
+		return FireSampler::Sample(diffuse, pixel.uv);
+	}
+}
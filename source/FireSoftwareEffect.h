@@ -0,0 +1,49 @@
+#pragma once
+#include "SoftwareEffect.h"
+#include "Texture.h"
+
+namespace dae
+{
+	// Software version of FireShader.fx: the unlit diffuse map, alpha blended over the opaque pixels.
+	class FireSoftwareEffect final : public SoftwareEffect
+	{
+	public:
+
+		FireSoftwareEffect() = default;
+		~FireSoftwareEffect() override = default;
+
+		FireSoftwareEffect(const FireSoftwareEffect&) = delete;
+		FireSoftwareEffect(FireSoftwareEffect&&) noexcept = delete;
+		FireSoftwareEffect& operator=(const FireSoftwareEffect&) = delete;
+		FireSoftwareEffect& operator=(FireSoftwareEffect&&) noexcept = delete;
+
+		bool IsTransparent() const override { return true; }
+		void BeginFrame(const RasterState& state) override;
+		void TransformVertices(Mesh& mesh, const Camera& camera) const override;
+		void DrawTile(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const override;
+
+		void SetDiffuseMap(Texture* pDiffuseTexture);
+
+	private:
+
+		// The pixel stage handed to SoftwareRaster::RasterizeBlended.
+		struct PixelShader
+		{
+			const Texture& diffuse;
+
+			ColorRGB Shade(const Vertex_Out& pixel, float& alpha) const;
+		};
+
+		using DrawTileFunction = void (FireSoftwareEffect::*)(const RasterState&, std::span<const RasterTriangle>, std::span<const uint32_t>, const Tile&) const;
+
+		Texture* m_pDiffuseFire{ nullptr };
+		DrawTileFunction m_pDrawTile{ nullptr };
+
+		// Functions.
+
+		template<Culling CullMode>
+		static DrawTileFunction GetDrawTile(DepthFormat depthFormat);
+		template<Culling CullMode, DepthFormat Format>
+		void DrawTileWith(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const;
+	};
+}
@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "FrameArena.h"
+
+#include "JobSystem.h"
+
+namespace dae
+{
+	FrameArena::FrameArena(size_t bytesPerThread)
+		: m_BytesPerThread(bytesPerThread)
+	{
+		Reset();
+	}
+
+	void FrameArena::Reset()
+	{
+		// The worker count only changes between frames, see JobSystem::Configure.
+		const size_t threadCount{ static_cast<size_t>(JobSystem::GetInstance().GetWorkerCount()) + 1 };
+		if (m_SubArenas.size() != threadCount)
+		{
+			m_SubArenas = std::vector<SubArena>(threadCount);
+		}
+
+		m_UsedBytes = 0;
+		for (SubArena& subArena : m_SubArenas)
+		{
+			size_t capacity{};
+			for (size_t blockIndex = 0; blockIndex < subArena.pBlocks.size(); ++blockIndex)
+			{
+				m_UsedBytes += blockIndex + 1 < subArena.pBlocks.size() ? subArena.blockSizes[blockIndex] : subArena.offset;
+				capacity += subArena.blockSizes[blockIndex];
+			}
+
+			// A frame that needed more than one block gets all of it as one block from now on.
+			if (subArena.pBlocks.size() != 1)
+			{
+				subArena.pBlocks.clear();
+				subArena.blockSizes.clear();
+				AddBlock(subArena, std::max(capacity, m_BytesPerThread));
+			}
+			subArena.offset = 0;
+		}
+	}
+
+	void* FrameArena::AllocateBytes(size_t bytes, size_t alignment)
+	{
+		const int threadIndex{ JobSystem::GetThreadIndex() };
+		assert(threadIndex < static_cast<int>(m_SubArenas.size()) && "The worker count changed without a Reset of the arena.");
+		SubArena& subArena{ m_SubArenas[threadIndex] };
+
+		// Block starts are aligned to 16 by new, the offset aligns within the block.
+		assert(alignment <= 16 && "Over aligned types are not supported by the arena.");
+		size_t alignedOffset{ (subArena.offset + alignment - 1) & ~(alignment - 1) };
+		if (alignedOffset + bytes > subArena.blockSizes.back())
+		{
+			AddBlock(subArena, std::max(bytes + alignment, subArena.blockSizes.back() * 2));
+			alignedOffset = 0;
+		}
+
+		subArena.offset = alignedOffset + bytes;
+		return subArena.pBlocks.back().get() + alignedOffset;
+	}
+
+	void FrameArena::AddBlock(SubArena& subArena, size_t bytes) const
+	{
+		subArena.pBlocks.emplace_back(std::make_unique<std::byte[]>(bytes));
+		subArena.blockSizes.emplace_back(bytes);
+	}
+
+	size_t FrameArena::GetCapacityBytes() const
+	{
+		size_t capacity{};
+		for (const SubArena& subArena : m_SubArenas)
+		{
+			for (const size_t blockSize : subArena.blockSizes)
+			{
+				capacity += blockSize;
+			}
+		}
+		return capacity;
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace dae
+{
+	// Bump allocator for the transient data of one frame: what it hands out lives until the next Reset, nothing is freed on its own.
+	// Every thread of the JobSystem allocates from its own sub-arena, so allocating takes no lock.
+	// A sub-arena that runs out chains another block, Reset merges them into one block big enough for the whole frame,
+	// so once the first frames have sized it the frame loop no longer touches the heap.
+	class FrameArena final
+	{
+	public:
+
+		explicit FrameArena(size_t bytesPerThread = 64 * 1024);
+		~FrameArena() = default;
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena(FrameArena&&) noexcept = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+		FrameArena& operator=(FrameArena&&) noexcept = delete;
+
+		// Everything handed out since the last Reset is gone. No thread may allocate from the arena meanwhile.
+		void Reset();
+
+		// Default constructed objects, from the sub-arena of the calling thread.
+		// Only the render thread and the JobSystem's workers may allocate, other threads would share the render thread's sub-arena.
+		template<typename T>
+		std::span<T> Allocate(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "The arena never runs destructors.");
+			T* pObjects{ static_cast<T*>(AllocateBytes(sizeof(T) * count, alignof(T))) };
+			std::uninitialized_default_construct_n(pObjects, count);
+			return std::span<T>{ pObjects, count };
+		}
+
+		// Over every thread, of the frame before the last Reset.
+		size_t GetUsedBytes() const { return m_UsedBytes; }
+		size_t GetCapacityBytes() const;
+
+	private:
+
+		// Padded to a cache line, the offsets of neighbouring threads are written constantly.
+		struct alignas(64) SubArena
+		{
+			std::vector<std::unique_ptr<std::byte[]>> pBlocks{};
+			std::vector<size_t> blockSizes{};
+			size_t offset{};
+		};
+
+		size_t m_BytesPerThread{};
+		size_t m_UsedBytes{};
+		std::vector<SubArena> m_SubArenas{};
+
+		// Functions.
+
+		void* AllocateBytes(size_t bytes, size_t alignment);
+		void AddBlock(SubArena& subArena, size_t bytes) const;
+	};
+}
@@ -41,25 +41,7 @@ namespace dae
 			m_pSwapChain->Release();
 		}
 
-		if (m_pDepthStencilBuffer)
-		{
-			m_pDepthStencilBuffer->Release();
-		}
-
-		if (m_pDepthStencilView)
-		{
-			m_pDepthStencilView->Release();
-		}
-
-		if (m_pRenderTargetBuffer)
-		{
-			m_pRenderTargetBuffer->Release();
-		}
-
-		if (m_pRenderTargetView)
-		{
-			m_pRenderTargetView->Release();
-		}
+		ReleaseRenderTargets();
 
 		if (m_pNoneRasterizerState)
 		{
@@ -92,9 +74,12 @@ namespace dae
 
 		// Set Pipeline + Invoke Drawcalls (=Render)
 
-		m_pVehicleMesh->Render(m_pDeviceContext);
+		if (m_pVehicleMesh)
+		{
+			m_pVehicleMesh->Render(m_pDeviceContext);
+		}
 
-		if (m_ToggleFireMesh)
+		if (m_ToggleFireMesh && m_pFireMesh)
 		{
 			m_pFireMesh->Render(m_pDeviceContext);
 		}
@@ -104,6 +89,33 @@ namespace dae
 		m_pSwapChain->Present(0, 0);
 	}
 
+	void Hardware::Resize(int width, int height)
+	{
+		if (!m_IsInitialized || (width == m_Width && height == m_Height))
+		{
+			return;
+		}
+
+		m_Width = width;
+		m_Height = height;
+
+		// The swap chain only resizes once nothing references its buffers.
+		m_pDeviceContext->OMSetRenderTargets(0, nullptr, nullptr);
+		ReleaseRenderTargets();
+
+		HRESULT result = m_pSwapChain->ResizeBuffers(0, m_Width, m_Height, DXGI_FORMAT_UNKNOWN, 0);
+		if (SUCCEEDED(result))
+		{
+			result = CreateRenderTargets();
+		}
+
+		if (FAILED(result))
+		{
+			m_IsInitialized = false;
+			std::cout << "DirectX resize failed!\n";
+		}
+	}
+
 	void Hardware::CycleFilteringMode() const
 	{
 		m_pVehicleMesh->CycleFilteringMode();
@@ -208,57 +220,12 @@ namespace dae
 			return result;
 		}
 
-		// Create DepthStencil & DepthStencilView.		
-		//Resource
-		D3D11_TEXTURE2D_DESC depthStencilDesc{};
-		depthStencilDesc.Width = m_Width;
-		depthStencilDesc.Height = m_Height;
-		depthStencilDesc.MipLevels = 1;
-		depthStencilDesc.ArraySize = 1;
-		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-		depthStencilDesc.SampleDesc.Count = 1;
-		depthStencilDesc.SampleDesc.Quality = 0;
-		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
-		depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-		depthStencilDesc.CPUAccessFlags = 0;
-		depthStencilDesc.MiscFlags = 0;
-
-		// View
-		D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc{};
-		depthStencilViewDesc.Format = depthStencilViewDesc.Format;
-		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-		depthStencilViewDesc.Texture2D.MipSlice = 0;
-
-		result = m_pDevice->CreateTexture2D(&depthStencilDesc, nullptr, &m_pDepthStencilBuffer);
-		if (FAILED(result))
-		{
-			return result;
-		}
-
-		result = m_pDevice->CreateDepthStencilView(m_pDepthStencilBuffer, &depthStencilViewDesc, &m_pDepthStencilView);
+		result = CreateRenderTargets();
 		if (FAILED(result))
 		{
 			return result;
 		}
 
-		// Create RenderTarget & RenderTargetView.
-		// Resource
-		result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_pRenderTargetBuffer));
-		if (FAILED(result))
-		{
-			return result;
-		}
-
-		// View
-		result = m_pDevice->CreateRenderTargetView(m_pRenderTargetBuffer, nullptr, &m_pRenderTargetView);
-		if (FAILED(result))
-		{
-			return result;
-		}
-
-		// Bind RenderTargetView and DepthStencilView to Output Merger Stage.
-		m_pDeviceContext->OMSetRenderTargets(1, &m_pRenderTargetView, m_pDepthStencilView);
-
 		// Rasterizer States.
 		// None Culling.
 		D3D11_RASTERIZER_DESC descNone{};
@@ -320,6 +287,63 @@ namespace dae
 		// Set None culling as default.
 		m_pDeviceContext->RSSetState(m_pNoneRasterizerState);
 
+		return result;
+
+	}
+
+	HRESULT Hardware::CreateRenderTargets()
+	{
+		// Create DepthStencil & DepthStencilView.
+		//Resource
+		D3D11_TEXTURE2D_DESC depthStencilDesc{};
+		depthStencilDesc.Width = m_Width;
+		depthStencilDesc.Height = m_Height;
+		depthStencilDesc.MipLevels = 1;
+		depthStencilDesc.ArraySize = 1;
+		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		depthStencilDesc.SampleDesc.Count = 1;
+		depthStencilDesc.SampleDesc.Quality = 0;
+		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
+		depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+		depthStencilDesc.CPUAccessFlags = 0;
+		depthStencilDesc.MiscFlags = 0;
+
+		// View
+		D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc{};
+		depthStencilViewDesc.Format = depthStencilViewDesc.Format;
+		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+		depthStencilViewDesc.Texture2D.MipSlice = 0;
+
+		HRESULT result{ m_pDevice->CreateTexture2D(&depthStencilDesc, nullptr, &m_pDepthStencilBuffer) };
+		if (FAILED(result))
+		{
+			return result;
+		}
+
+		result = m_pDevice->CreateDepthStencilView(m_pDepthStencilBuffer, &depthStencilViewDesc, &m_pDepthStencilView);
+		if (FAILED(result))
+		{
+			return result;
+		}
+
+		// Create RenderTarget & RenderTargetView.
+		// Resource
+		result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_pRenderTargetBuffer));
+		if (FAILED(result))
+		{
+			return result;
+		}
+
+		// View
+		result = m_pDevice->CreateRenderTargetView(m_pRenderTargetBuffer, nullptr, &m_pRenderTargetView);
+		if (FAILED(result))
+		{
+			return result;
+		}
+
+		// Bind RenderTargetView and DepthStencilView to Output Merger Stage.
+		m_pDeviceContext->OMSetRenderTargets(1, &m_pRenderTargetView, m_pDepthStencilView);
+
 		// Set Viewport.
 		D3D11_VIEWPORT viewport{};
 		viewport.Width = static_cast<float>(m_Width);
@@ -330,8 +354,34 @@ namespace dae
 		viewport.MaxDepth = 1.0f;
 		m_pDeviceContext->RSSetViewports(1, &viewport);
 
-		return result;
+		return S_OK;
+	}
 
+	void Hardware::ReleaseRenderTargets()
+	{
+		if (m_pDepthStencilBuffer)
+		{
+			m_pDepthStencilBuffer->Release();
+			m_pDepthStencilBuffer = nullptr;
+		}
+
+		if (m_pDepthStencilView)
+		{
+			m_pDepthStencilView->Release();
+			m_pDepthStencilView = nullptr;
+		}
+
+		if (m_pRenderTargetBuffer)
+		{
+			m_pRenderTargetBuffer->Release();
+			m_pRenderTargetBuffer = nullptr;
+		}
+
+		if (m_pRenderTargetView)
+		{
+			m_pRenderTargetView->Release();
+			m_pRenderTargetView = nullptr;
+		}
 	}
 
 	void Hardware::SetMeshs(Mesh* pMesh1, Mesh* pMesh2)
@@ -20,6 +20,8 @@ namespace dae
 		Hardware& operator=(Hardware&&) noexcept = delete;
 
 		void Render() const;
+		// Resizes the swap chain and recreates the render target and depth buffer for the new window size.
+		void Resize(int width, int height);
 		void SetMeshs(Mesh* pMesh1, Mesh* pMesh2);
 		void CycleFilteringMode() const;
 		void CycleCullMode();
@@ -33,8 +35,8 @@ namespace dae
 		int m_Width{};
 		int m_Height{};
 
-		Mesh* m_pVehicleMesh;
-		Mesh* m_pFireMesh;
+		Mesh* m_pVehicleMesh{ nullptr };
+		Mesh* m_pFireMesh{ nullptr };
 
 		Culling m_CurrentCullingMode{ Culling::Back };
 
@@ -57,6 +59,8 @@ namespace dae
 
 		// Functions.
 		HRESULT InitializeDirectX();
+		HRESULT CreateRenderTargets();
+		void ReleaseRenderTargets();
 
 	};
 
@@ -0,0 +1,405 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+#include <chrono>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		// The queue the current thread pushes to and pops from first.
+		thread_local int t_QueueIndex{ 0 };
+
+		// Busy time accounting, the main thread counts as busy unless it waits, workers as idle unless they run a job.
+		thread_local bool t_IsBusy{ true };
+		thread_local std::chrono::steady_clock::time_point t_LastTransition{ std::chrono::steady_clock::now() };
+
+		void PinToCore(std::thread& thread, int core)
+		{
+#if defined(_WIN32)
+			SetThreadAffinityMask(static_cast<HANDLE>(thread.native_handle()), DWORD_PTR{ 1 } << core);
+#elif defined(__linux__)
+			cpu_set_t cpuSet{};
+			CPU_ZERO(&cpuSet);
+			CPU_SET(core, &cpuSet);
+			pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+#else
+			(void)thread;
+			(void)core;
+#endif
+		}
+	}
+
+	struct JobSystem::Job
+	{
+		std::function<void()> task{};
+		// The job itself counts as one until Schedule has registered it with every dependency.
+		std::atomic<int> unfinishedDependencies{ 1 };
+
+		// Guards dependents, set together with isFinished.
+		std::mutex mutex{};
+		std::atomic<bool> isFinished{ false };
+		std::vector<JobHandle> dependents{};
+	};
+
+	JobSystem::JobSystem()
+	{
+		StartWorkers(GetDefaultWorkerCount());
+	}
+
+	template<typename T>
+	struct JobSystem::JobAllocator
+	{
+		using value_type = T;
+
+		JobSystem* pJobSystem{};
+
+		explicit JobAllocator(JobSystem* pJobSystem) : pJobSystem(pJobSystem) {}
+		template<typename U>
+		JobAllocator(const JobAllocator<U>& other) : pJobSystem(other.pJobSystem) {}
+
+		T* allocate(size_t count)
+		{
+			assert(count == 1 && "Jobs are allocated one at a time.");
+			return static_cast<T*>(pJobSystem->AllocateJob(sizeof(T) * count));
+		}
+
+		void deallocate(T* pJob, size_t)
+		{
+			pJobSystem->FreeJob(pJob);
+		}
+
+		template<typename U>
+		bool operator==(const JobAllocator<U>& other) const { return pJobSystem == other.pJobSystem; }
+	};
+
+	JobSystem::~JobSystem()
+	{
+		StopWorkers();
+
+		for (void* pJob : m_pFreeJobs)
+		{
+			::operator delete(pJob);
+		}
+		m_pFreeJobs.clear();
+	}
+
+	void* JobSystem::AllocateJob(size_t size)
+	{
+		std::lock_guard lock{ m_PoolMutex };
+		// Every job has the same shared_ptr control block type, so one block size fits all of them.
+		assert((m_JobBlockSize == 0 || m_JobBlockSize == size) && "Jobs of different sizes in the pool.");
+		m_JobBlockSize = size;
+		if (m_pFreeJobs.empty())
+		{
+			return ::operator new(size);
+		}
+
+		void* pJob{ m_pFreeJobs.back() };
+		m_pFreeJobs.pop_back();
+		return pJob;
+	}
+
+	void JobSystem::FreeJob(void* pJob)
+	{
+		std::lock_guard lock{ m_PoolMutex };
+		m_pFreeJobs.push_back(pJob);
+	}
+
+	void JobSystem::WorkerQueue::PushBack(const JobHandle& job)
+	{
+		if (count == jobs.size())
+		{
+			// Unrolled into a buffer twice the size, the oldest job first.
+			std::vector<JobHandle> grown(jobs.size() * 2);
+			for (size_t i = 0; i < count; ++i)
+			{
+				grown[i] = std::move(jobs[(front + i) % jobs.size()]);
+			}
+			jobs.swap(grown);
+			front = 0;
+		}
+
+		jobs[(front + count) % jobs.size()] = job;
+		++count;
+	}
+
+	JobSystem::JobHandle JobSystem::WorkerQueue::PopBack()
+	{
+		--count;
+		return std::move(jobs[(front + count) % jobs.size()]);
+	}
+
+	JobSystem::JobHandle JobSystem::WorkerQueue::PopFront()
+	{
+		JobHandle job{ std::move(jobs[front]) };
+		front = (front + 1) % jobs.size();
+		--count;
+		return job;
+	}
+
+	int JobSystem::GetDefaultWorkerCount()
+	{
+		return std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+	}
+
+	int JobSystem::GetThreadIndex()
+	{
+		return t_QueueIndex;
+	}
+
+	void JobSystem::Configure(int workerCount, bool pinThreads)
+	{
+		assert(m_QueuedJobs == 0 && "Configure the JobSystem between frames.");
+
+		StopWorkers();
+		m_PinThreads = pinThreads;
+		StartWorkers(std::max(workerCount, 0));
+
+		std::cout << "Job System: " << m_Workers.size() << (m_PinThreads ? " pinned workers.\n" : " workers.\n");
+	}
+
+	void JobSystem::StartWorkers(int workerCount)
+	{
+		m_pQueues.clear();
+		m_pThreadTimes.clear();
+		for (int i = 0; i <= workerCount; ++i)
+		{
+			m_pQueues.push_back(std::make_unique<WorkerQueue>());
+			m_pThreadTimes.push_back(std::make_unique<ThreadTimes>());
+		}
+
+		const int coreCount{ std::max(static_cast<int>(std::thread::hardware_concurrency()), 1) };
+		for (int i = 0; i < workerCount; ++i)
+		{
+			m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+			if (m_PinThreads)
+			{
+				// Core 0 is left to the main thread.
+				PinToCore(m_Workers.back(), (i + 1) % coreCount);
+			}
+		}
+	}
+
+	void JobSystem::StopWorkers()
+	{
+		{
+			std::lock_guard lock{ m_WakeMutex };
+			m_IsStopping = true;
+		}
+		m_WakeCondition.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+		m_Workers.clear();
+		m_IsStopping = false;
+	}
+
+	JobSystem::JobHandle JobSystem::Schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies)
+	{
+		const JobHandle job{ std::allocate_shared<Job>(JobAllocator<Job>{ this }) };
+		job->task = std::move(task);
+
+		for (const JobHandle& dependency : dependencies)
+		{
+			std::lock_guard lock{ dependency->mutex };
+			if (!dependency->isFinished)
+			{
+				dependency->dependents.push_back(job);
+				++job->unfinishedDependencies;
+			}
+		}
+
+		if (--job->unfinishedDependencies == 0)
+		{
+			Push(job);
+		}
+		return job;
+	}
+
+	void JobSystem::Wait(const JobHandle& job)
+	{
+		const bool wasBusy{ t_IsBusy };
+		while (!job->isFinished)
+		{
+			if (!RunQueuedJob())
+			{
+				SetBusy(false);
+				std::this_thread::yield();
+			}
+		}
+		SetBusy(wasBusy);
+	}
+
+	void JobSystem::WaitUntilZero(const std::atomic<size_t>& remaining)
+	{
+		const bool wasBusy{ t_IsBusy };
+		while (remaining > 0)
+		{
+			if (!RunQueuedJob())
+			{
+				SetBusy(false);
+				std::this_thread::yield();
+			}
+		}
+		SetBusy(wasBusy);
+	}
+
+	void JobSystem::SetBusy(bool isBusy)
+	{
+		const auto now{ std::chrono::steady_clock::now() };
+		const int64_t elapsed{ std::chrono::duration_cast<std::chrono::nanoseconds>(now - t_LastTransition).count() };
+		t_LastTransition = now;
+
+		// Threads of a previous configuration are not counted.
+		if (t_QueueIndex < static_cast<int>(m_pThreadTimes.size()))
+		{
+			ThreadTimes& times{ *m_pThreadTimes[t_QueueIndex] };
+			(t_IsBusy ? times.busyNanoseconds : times.idleNanoseconds) += elapsed;
+		}
+		t_IsBusy = isBusy;
+	}
+
+	void JobSystem::Push(const JobHandle& job)
+	{
+		// Threads of a previous configuration fall back to the shared queue.
+		const int queueIndex{ t_QueueIndex < static_cast<int>(m_pQueues.size()) ? t_QueueIndex : 0 };
+		{
+			WorkerQueue& queue{ *m_pQueues[queueIndex] };
+			std::lock_guard lock{ queue.mutex };
+			queue.PushBack(job);
+		}
+		++m_QueuedJobs;
+
+		// Taking the lock orders this against a worker that just found nothing queued and is about to sleep.
+		{
+			std::lock_guard lock{ m_WakeMutex };
+		}
+		m_WakeCondition.notify_one();
+	}
+
+	JobSystem::JobHandle JobSystem::Pop(int queueIndex)
+	{
+		const int queueCount{ static_cast<int>(m_pQueues.size()) };
+
+		// Newest first from the own queue, its data is most likely still in cache.
+		{
+			WorkerQueue& queue{ *m_pQueues[queueIndex] };
+			std::lock_guard lock{ queue.mutex };
+			if (queue.count > 0)
+			{
+				JobHandle job{ queue.PopBack() };
+				--m_QueuedJobs;
+				return job;
+			}
+		}
+
+		// Oldest first from the others, those tend to be the biggest pieces of work.
+		for (int offset = 1; offset < queueCount; ++offset)
+		{
+			WorkerQueue& queue{ *m_pQueues[(queueIndex + offset) % queueCount] };
+			std::lock_guard lock{ queue.mutex };
+			if (queue.count > 0)
+			{
+				JobHandle job{ queue.PopFront() };
+				--m_QueuedJobs;
+				++m_StolenJobs;
+				return job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool JobSystem::RunQueuedJob()
+	{
+		const int queueIndex{ t_QueueIndex < static_cast<int>(m_pQueues.size()) ? t_QueueIndex : 0 };
+		const JobHandle job{ Pop(queueIndex) };
+		if (!job)
+		{
+			return false;
+		}
+
+		Execute(job);
+		return true;
+	}
+
+	void JobSystem::Execute(const JobHandle& job)
+	{
+		const bool wasBusy{ t_IsBusy };
+		SetBusy(true);
+		job->task();
+		SetBusy(wasBusy);
+		++m_ExecutedJobs;
+
+		std::vector<JobHandle> dependents{};
+		{
+			std::lock_guard lock{ job->mutex };
+			job->isFinished = true;
+			dependents.swap(job->dependents);
+		}
+
+		for (const JobHandle& dependent : dependents)
+		{
+			if (--dependent->unfinishedDependencies == 0)
+			{
+				Push(dependent);
+			}
+		}
+	}
+
+	void JobSystem::WorkerLoop(int queueIndex)
+	{
+		t_QueueIndex = queueIndex;
+		t_IsBusy = false;
+		t_LastTransition = std::chrono::steady_clock::now();
+
+		while (true)
+		{
+			if (const JobHandle job{ Pop(queueIndex) })
+			{
+				Execute(job);
+				continue;
+			}
+
+			std::unique_lock lock{ m_WakeMutex };
+			m_WakeCondition.wait(lock, [this] { return m_QueuedJobs > 0 || m_IsStopping; });
+			if (m_IsStopping)
+			{
+				return;
+			}
+			// Books the sleep as idle time.
+			SetBusy(false);
+		}
+	}
+
+	void JobSystem::PrintStats()
+	{
+		const uint64_t executedJobs{ m_ExecutedJobs };
+		const uint64_t stolenJobs{ m_StolenJobs };
+		std::cout << "Job System: " << GetWorkerCount() << " workers, " << executedJobs << " jobs run, "
+			<< stolenJobs << " stolen (" << (executedJobs > 0 ? 100 * stolenJobs / executedJobs : 0) << "%)\n";
+
+		// Books the reporting thread's time up to now.
+		SetBusy(t_IsBusy);
+
+		std::cout << "Busy per thread:";
+		for (size_t i = 0; i < m_pThreadTimes.size(); ++i)
+		{
+			const int64_t busy{ m_pThreadTimes[i]->busyNanoseconds.exchange(0) };
+			const int64_t idle{ m_pThreadTimes[i]->idleNanoseconds.exchange(0) };
+			const int64_t total{ busy + idle };
+			std::cout << (i == 0 ? " main " : " ") << (total > 0 ? 100 * busy / total : 0) << "%";
+		}
+		std::cout << "\n";
+	}
+}
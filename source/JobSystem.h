@@ -0,0 +1,199 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	// Portable replacement for concurrency::parallel_for. Every thread owns a deque of jobs, idle workers steal from the others.
+	// A thread waiting on a job runs queued jobs until it is finished, so waiting inside a job never deadlocks.
+	class JobSystem final
+	{
+	public:
+
+		struct Job;
+		using JobHandle = std::shared_ptr<Job>;
+
+		static JobSystem& GetInstance()
+		{
+			static JobSystem instance{};
+			return instance;
+		}
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem(JobSystem&&) noexcept = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		JobSystem& operator=(JobSystem&&) noexcept = delete;
+
+		// One thread per core besides the one that waits.
+		static int GetDefaultWorkerCount();
+
+		// Restarts the workers, only while no job is queued. With 0 workers every job runs on the thread that waits for it.
+		// Pinned workers each stay on their own core.
+		void Configure(int workerCount, bool pinThreads);
+		int GetWorkerCount() const { return static_cast<int>(m_Workers.size()); }
+		// 0 on every thread that is not a worker, worker i is i + 1. Per thread data of the workers can be indexed with it.
+		static int GetThreadIndex();
+
+		// Queued once every dependency has finished.
+		JobHandle Schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies = {});
+		void Wait(const JobHandle& job);
+
+		// Calls function(i) for every i in [begin, end), grainSize indices per job. A grainSize of 0 makes about 4 jobs per thread.
+		template<typename Index, typename Function>
+		void ParallelFor(Index begin, Index end, Index grainSize, const Function& function);
+
+		// Calls function(i) for every i in [0, count), every thread that joins claims the next index in order.
+		// With the work sorted most expensive first, the costly items start first and the cheap ones fill the gaps at the end.
+		template<typename Function>
+		void ParallelForOrdered(size_t count, const Function& function);
+
+		// Jobs run and stolen, and how busy every thread was since the last report.
+		void PrintStats();
+
+	private:
+
+		JobSystem();
+
+		// Ring buffer of jobs: the owner pushes and pops at the back, thieves take from the front. Grows, never shrinks.
+		struct WorkerQueue
+		{
+			std::mutex mutex{};
+			std::vector<JobHandle> jobs{ std::vector<JobHandle>(64) };
+			size_t front{};
+			size_t count{};
+
+			void PushBack(const JobHandle& job);
+			JobHandle PopBack();
+			JobHandle PopFront();
+		};
+
+		// Hands the memory of finished jobs to the next ones, so scheduling stops allocating once the frame loop has run a while.
+		template<typename T>
+		struct JobAllocator;
+
+		// Time a thread spent running jobs and time it spent looking for or waiting on them, per queue.
+		struct alignas(64) ThreadTimes
+		{
+			std::atomic<int64_t> busyNanoseconds{};
+			std::atomic<int64_t> idleNanoseconds{};
+		};
+
+		std::vector<std::thread> m_Workers{};
+		// Queue 0 belongs to every thread that is not a worker, worker i owns queue i + 1.
+		std::vector<std::unique_ptr<WorkerQueue>> m_pQueues{};
+		std::vector<std::unique_ptr<ThreadTimes>> m_pThreadTimes{};
+		bool m_PinThreads{ false };
+
+		std::mutex m_WakeMutex{};
+		std::condition_variable m_WakeCondition{};
+		std::atomic<int> m_QueuedJobs{};
+		std::atomic<bool> m_IsStopping{ false };
+
+		std::atomic<uint64_t> m_ExecutedJobs{};
+		std::atomic<uint64_t> m_StolenJobs{};
+
+		std::mutex m_PoolMutex{};
+		std::vector<void*> m_pFreeJobs{};
+		size_t m_JobBlockSize{};
+
+		// Functions.
+
+		void StartWorkers(int workerCount);
+		void StopWorkers();
+		void WorkerLoop(int queueIndex);
+		void Push(const JobHandle& job);
+		JobHandle Pop(int queueIndex);
+		bool RunQueuedJob();
+		void Execute(const JobHandle& job);
+		// Wait for the jobs of a parallel loop, which count remaining down as they finish.
+		void WaitUntilZero(const std::atomic<size_t>& remaining);
+		void SetBusy(bool isBusy);
+		void* AllocateJob(size_t size);
+		void FreeJob(void* pJob);
+	};
+
+	template<typename Index, typename Function>
+	void JobSystem::ParallelFor(Index begin, Index end, Index grainSize, const Function& function)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+
+		const Index count{ end - begin };
+		if (grainSize == 0)
+		{
+			grainSize = std::max(count / static_cast<Index>((GetWorkerCount() + 1) * 4), Index{ 1 });
+		}
+
+		// Nobody to share a single job with.
+		if (count <= grainSize || GetWorkerCount() == 0)
+		{
+			for (Index i{ begin }; i < end; ++i)
+			{
+				function(i);
+			}
+			return;
+		}
+
+		// Chunks are counted instead of keeping every handle, and capture only the loop and their begin,
+		// small enough for the task to live inside its std::function. So the loop itself allocates nothing.
+		struct Loop
+		{
+			const Function& function;
+			Index end;
+			Index grainSize;
+			std::atomic<size_t> remainingChunks;
+		};
+		Loop loop{ function, end, grainSize, static_cast<size_t>((count + grainSize - 1) / grainSize) };
+
+		for (Index chunkBegin{ begin }; chunkBegin < end; chunkBegin += std::min(grainSize, end - chunkBegin))
+		{
+			Schedule([&loop, chunkBegin]
+			{
+				const Index chunkEnd{ chunkBegin + std::min(loop.grainSize, loop.end - chunkBegin) };
+				for (Index i{ chunkBegin }; i < chunkEnd; ++i)
+				{
+					loop.function(i);
+				}
+				--loop.remainingChunks;
+			});
+		}
+
+		WaitUntilZero(loop.remainingChunks);
+	}
+
+	template<typename Function>
+	void JobSystem::ParallelForOrdered(size_t count, const Function& function)
+	{
+		std::atomic<size_t> next{};
+		const auto run = [&next, count, &function]
+		{
+			for (size_t i{ next++ }; i < count; i = next++)
+			{
+				function(i);
+			}
+		};
+
+		// The calling thread runs too, runners that start late find nothing left and return.
+		const size_t runnerCount{ std::min(count, static_cast<size_t>(GetWorkerCount())) };
+		std::atomic<size_t> remainingRunners{ runnerCount };
+		for (size_t i{}; i < runnerCount; ++i)
+		{
+			Schedule([&run, &remainingRunners]
+			{
+				run();
+				--remainingRunners;
+			});
+		}
+
+		run();
+		WaitUntilZero(remainingRunners);
+	}
+}
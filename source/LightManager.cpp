@@ -18,7 +18,7 @@ namespace dae
 		m_pLightContainer.push_back(pObject);
 	}
 
-	std::vector<Lights*> LightManager::GetLights() const
+	const std::vector<Lights*>& LightManager::GetLights() const
 	{
 		return m_pLightContainer;
 	}
@@ -19,7 +19,7 @@ namespace dae
 		LightManager& operator=(LightManager&&) noexcept = default;
 
 		void add(Lights* pObject);
-		std::vector<Lights*> GetLights() const;
+		const std::vector<Lights*>& GetLights() const;
 
 	private:
 		LightManager() = default;
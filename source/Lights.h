@@ -1,16 +1,45 @@
 #pragma once
+#include <algorithm>
 #include "Math.h"
 
 namespace dae
 {
+	enum class LightType
+	{
+		Directional, Point, Spot
+	};
+
 	class Lights
 	{
 	public:
 		Lights() = default;
-		~Lights() = default;
+		virtual ~Lights() = default;
 
+		virtual LightType GetType() const = 0;
 		virtual Vector3 GetDirection() const = 0;
 		virtual float GetlightIntensity() const = 0;
 
+		// Only lights with a bounded range have a position, the others reach every pixel.
+		virtual Vector3 GetPosition() const { return Vector3::Zero; }
+		virtual float GetRange() const { return FLT_MAX; }
+
+		// Cosines of the half angles where a spot light starts to fade and where it is gone.
+		virtual float GetInnerConeCos() const { return -1.f; }
+		virtual float GetOuterConeCos() const { return -1.f; }
+
+		// Inverse square falloff, windowed so it reaches 0 at the range (same as PosCol3D.fx).
+		static float GetDistanceAttenuation(float distance, float range)
+		{
+			const float ratio{ distance / range };
+			const float window{ std::clamp(1.f - ratio * ratio * ratio * ratio, 0.f, 1.f) };
+			return window * window / (distance * distance + 1.f);
+		}
+
+		static float GetConeAttenuation(float cosAngle, float innerConeCos, float outerConeCos)
+		{
+			const float fade{ std::clamp((cosAngle - outerConeCos) / std::max(innerConeCos - outerConeCos, 1e-4f), 0.f, 1.f) };
+			return fade * fade;
+		}
+
 	};
 }
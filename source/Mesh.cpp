@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Mesh.h"
+#include "SoftwareEffect.h"
 
 namespace dae
 {
@@ -91,6 +92,20 @@ namespace dae
 			return;
 		}
 
+		// Bounding sphere around the box of the vertices.
+		Vector3 boundsMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+		Vector3 boundsMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (const Vertex_In& v : m_VerticesIn)
+		{
+			boundsMin = Vector3::Min(boundsMin, v.position);
+			boundsMax = Vector3::Max(boundsMax, v.position);
+		}
+		m_BoundingCenter = (boundsMin + boundsMax) * 0.5f;
+		for (const Vertex_In& v : m_VerticesIn)
+		{
+			m_BoundingRadius = std::max(m_BoundingRadius, (v.position - m_BoundingCenter).Magnitude());
+		}
+
 		// Set Textures.
 		m_pEffect->SetDiffuseMap(diffuse);
 		m_pEffect->SetNormalMap(normal);
@@ -119,6 +134,15 @@ namespace dae
 		delete m_pEffect;
 		m_pEffect = nullptr;
 
+		delete m_pSoftwareEffect;
+		m_pSoftwareEffect = nullptr;
+
+	}
+
+	void Mesh::SetSoftwareEffect(SoftwareEffect* pSoftwareEffect)
+	{
+		delete m_pSoftwareEffect;
+		m_pSoftwareEffect = pSoftwareEffect;
 	}
 
 	void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
@@ -163,6 +187,24 @@ namespace dae
 		m_pEffect->CycleFilteringMode();
 	}
 
+	size_t Mesh::SetLights(const std::vector<Lights*>& pLights)
+	{
+		const Vector3 center{ GetWorldBoundingCenter() };
+
+		m_pReachingLights.clear();
+		for (Lights* pLight : pLights)
+		{
+			const float range{ pLight->GetRange() };
+			if (range == FLT_MAX || (pLight->GetPosition() - center).Magnitude() <= range + m_BoundingRadius)
+			{
+				m_pReachingLights.emplace_back(pLight);
+			}
+		}
+
+		m_pEffect->SetLights(m_pReachingLights);
+		return m_pReachingLights.size();
+	}
+
 	void Mesh::RotateY(float angle)
 	{
 		m_WorldMatrix = Matrix::CreateRotationY(angle * TO_RADIANS) * m_WorldMatrix;
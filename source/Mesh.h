@@ -6,6 +6,8 @@
 
 namespace dae
 {
+	class SoftwareEffect;
+
 	class Mesh final
 	{
 	public:
@@ -26,6 +28,17 @@ namespace dae
 		void Update(const Camera& camera, const Timer* pTimer);
 		void CycleFilteringMode() const;
 
+		// Software counterpart of the effect, owned by the mesh like the effect.
+		void SetSoftwareEffect(SoftwareEffect* pSoftwareEffect);
+		SoftwareEffect* GetSoftwareEffect() const { return m_pSoftwareEffect; }
+
+		// Binds the lights whose range reaches the mesh's bounding sphere, returns how many reach it.
+		size_t SetLights(const std::vector<Lights*>& pLights);
+
+		// World space bounding sphere, the world matrix only rotates and translates so the radius stays the same.
+		Vector3 GetWorldBoundingCenter() const { return m_WorldMatrix.TransformPoint(m_BoundingCenter); }
+		float GetBoundingRadius() const { return m_BoundingRadius; }
+
 		void RotateY(float angle);
 		void RotateX(float angle);
 		void RotateZ(float angle);
@@ -50,10 +63,16 @@ namespace dae
 
 		// DIRECTX Variables.
 		Effect* m_pEffect;
+		SoftwareEffect* m_pSoftwareEffect{ nullptr };
 		ID3D11InputLayout* m_pInputLayout;
 		ID3D11Buffer* m_pVertexBuffer;
 		ID3D11Buffer* m_pIndexBuffer;
 		uint32_t m_NumIndices;
 
+		// Bounding sphere in object space.
+		Vector3 m_BoundingCenter{};
+		float m_BoundingRadius{};
+		std::vector<Lights*> m_pReachingLights{};
+
 	};
 }
\ No newline at end of file
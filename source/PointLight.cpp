@@ -0,0 +1,39 @@
+#include "pch.h"
+#include "PointLight.h"
+
+namespace dae
+{
+
+	PointLight::PointLight(const Vector3& position, float range, float lightIntensity)
+		: m_Position{ position }
+		, m_Range{ range }
+		, m_LightIntensity{ lightIntensity }
+	{
+	}
+
+	LightType PointLight::GetType() const
+	{
+		return LightType::Point;
+	}
+
+	Vector3 PointLight::GetDirection() const
+	{
+		// Shines in every direction, the direction is per pixel.
+		return Vector3::Zero;
+	}
+
+	float PointLight::GetlightIntensity() const
+	{
+		return m_LightIntensity;
+	}
+
+	Vector3 PointLight::GetPosition() const
+	{
+		return m_Position;
+	}
+
+	float PointLight::GetRange() const
+	{
+		return m_Range;
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "Lights.h"
+
+namespace dae
+{
+	class PointLight : public Lights
+	{
+	public:
+		PointLight(const Vector3& position, float range, float lightIntensity);
+		~PointLight() override = default;
+
+		PointLight(const PointLight&) = default;
+		PointLight(PointLight&&) noexcept = default;
+		PointLight& operator=(const PointLight&) = default;
+		PointLight& operator=(PointLight&&) noexcept = default;
+
+		virtual LightType GetType() const override;
+		virtual Vector3 GetDirection() const override;
+		virtual float GetlightIntensity() const override;
+		virtual Vector3 GetPosition() const override;
+		virtual float GetRange() const override;
+
+	private:
+		Vector3 m_Position;
+		float m_Range;
+		float m_LightIntensity;
+
+	};
+}
@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "Presenter.h"
+
+namespace dae
+{
+	Presenter::Presenter(SDL_Window* pWindow)
+		: m_pWindow(pWindow)
+	{
+		m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
+		m_Thread = std::thread{ &Presenter::PresentLoop, this };
+	}
+
+	Presenter::~Presenter()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_Condition.notify_all();
+		m_Thread.join();
+	}
+
+	void Presenter::Submit(SDL_Surface* pSurface)
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			if (m_Mode == Mode::Mailbox)
+			{
+				m_DroppedCount += m_pQueue.size();
+				m_pQueue.clear();
+			}
+			m_pQueue.push_back(pSurface);
+		}
+		// Wakes the present thread, and anyone waiting on a surface a mailbox drop just released.
+		m_Condition.notify_all();
+	}
+
+	void Presenter::WaitUntilReleased(const SDL_Surface* pSurface)
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this, pSurface] { return !IsInUse(pSurface); });
+	}
+
+	void Presenter::Flush()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this] { return m_pQueue.empty() && !m_pPresenting; });
+	}
+
+	void Presenter::Resize()
+	{
+		Flush();
+		std::lock_guard lock{ m_Mutex };
+		m_pFrontBuffer = SDL_GetWindowSurface(m_pWindow);
+	}
+
+	bool Presenter::IsInUse(const SDL_Surface* pSurface) const
+	{
+		return m_pPresenting == pSurface || std::find(m_pQueue.begin(), m_pQueue.end(), pSurface) != m_pQueue.end();
+	}
+
+	void Presenter::PresentLoop()
+	{
+		while (true)
+		{
+			SDL_Surface* pSurface{ nullptr };
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_Condition.wait(lock, [this] { return !m_pQueue.empty() || m_IsStopping; });
+				if (m_IsStopping)
+				{
+					return;
+				}
+
+				pSurface = m_pQueue.front();
+				m_pQueue.erase(m_pQueue.begin());
+				m_pPresenting = pSurface;
+			}
+
+			Present(pSurface);
+
+			{
+				std::lock_guard lock{ m_Mutex };
+				m_pPresenting = nullptr;
+				++m_PresentedCount;
+			}
+			m_Condition.notify_all();
+		}
+	}
+
+	void Presenter::Present(SDL_Surface* pSurface) const
+	{
+		// A frame rendered into the window surface only needs the update, SDL copies it out to the screen in there.
+		if (pSurface == m_pFrontBuffer)
+		{
+			SDL_UpdateWindowSurface(m_pWindow);
+			return;
+		}
+
+		// The back buffers are created in the window's format, so the pixels are copied as they are instead of through the blitter.
+		const bool isSameLayout{ pSurface->format->format == m_pFrontBuffer->format->format && pSurface->w == m_pFrontBuffer->w && pSurface->h == m_pFrontBuffer->h };
+		if (isSameLayout)
+		{
+			SDL_LockSurface(m_pFrontBuffer);
+			const size_t rowBytes{ static_cast<size_t>(pSurface->w) * pSurface->format->BytesPerPixel };
+			for (int y = 0; y < pSurface->h; ++y)
+			{
+				std::memcpy(static_cast<uint8_t*>(m_pFrontBuffer->pixels) + y * m_pFrontBuffer->pitch, static_cast<const uint8_t*>(pSurface->pixels) + y * pSurface->pitch, rowBytes);
+			}
+			SDL_UnlockSurface(m_pFrontBuffer);
+		}
+		else
+		{
+			SDL_BlitSurface(pSurface, 0, m_pFrontBuffer, 0);
+		}
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+
+	void Presenter::ToggleMode()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_Mode = m_Mode == Mode::Fifo ? Mode::Mailbox : Mode::Fifo;
+		}
+		std::cout << (m_Mode == Mode::Fifo ? "Present Mode: FIFO.\n" : "Present Mode: Mailbox.\n");
+	}
+
+	void Presenter::PrintStats() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		std::cout << "Presented frames: " << m_PresentedCount << ", dropped: " << m_DroppedCount << "\n";
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct SDL_Window;
+struct SDL_Surface;
+
+namespace dae
+{
+	// Copies finished software back buffers to the window on its own thread, so the renderer starts the next frame immediately.
+	// A submitted surface belongs to the Presenter until it is released: presented, or dropped in mailbox mode.
+	class Presenter final
+	{
+	public:
+
+		enum class Mode
+		{
+			// Every frame, in order.
+			Fifo,
+			// Only the newest frame, the ones still waiting are dropped.
+			Mailbox
+		};
+
+		explicit Presenter(SDL_Window* pWindow);
+		~Presenter();
+
+		Presenter(const Presenter&) = delete;
+		Presenter(Presenter&&) noexcept = delete;
+		Presenter& operator=(const Presenter&) = delete;
+		Presenter& operator=(Presenter&&) noexcept = delete;
+
+		void Submit(SDL_Surface* pSurface);
+		// Blocks until the surface is no longer queued or being presented, before it is rendered into again.
+		void WaitUntilReleased(const SDL_Surface* pSurface);
+		// Blocks until every submitted frame is released, before something else draws to the window.
+		void Flush();
+		// SDL recreates the window surface when the window is resized, the next present picks up the new one.
+		void Resize();
+		// A frame rendered straight into it is presented without a copy. Only safe to write once Flush returned.
+		SDL_Surface* GetWindowSurface() const { return m_pFrontBuffer; }
+
+		void ToggleMode();
+		void PrintStats() const;
+
+	private:
+
+		SDL_Window* m_pWindow{};
+		SDL_Surface* m_pFrontBuffer{ nullptr };
+
+		Mode m_Mode{ Mode::Fifo };
+
+		mutable std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		// Oldest first. Holds at most one surface per frame slot, so once it held them it no longer allocates.
+		std::vector<SDL_Surface*> m_pQueue{};
+		const SDL_Surface* m_pPresenting{ nullptr };
+		bool m_IsStopping{ false };
+
+		size_t m_PresentedCount{};
+		size_t m_DroppedCount{};
+
+		std::thread m_Thread{};
+
+		// Functions.
+
+		void PresentLoop();
+		void Present(SDL_Surface* pSurface) const;
+		bool IsInUse(const SDL_Surface* pSurface) const;
+	};
+}
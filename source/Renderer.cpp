@@ -7,14 +7,32 @@
 #include "Effect.h"
 #include "VehicleEffect.h"
 #include "FireEffect.h"
+#include "VehicleSoftwareEffect.h"
+#include "FireSoftwareEffect.h"
 #include "LightManager.h"
 #include "DirectionalLight.h"
+#include "PointLight.h"
+#include "SpotLight.h"
+#include "AssetLoader.h"
+#include "TextureManager.h"
+#include "VirtualTexture.h"
 
 
 namespace dae
 {
 	Renderer::Renderer(SDL_Window* pWindow)
 	{
+		// Start decoding the textures and parsing the meshes on the loader's workers,
+		// creating the DirectX device below overlaps with it.
+		AssetLoader assetLoader{};
+		auto vehicleMeshData = assetLoader.LoadMesh("Resources/vehicle.obj");
+		auto fireMeshData = assetLoader.LoadMesh("Resources/fireFX.obj");
+		auto diffuseVehicleSurface = assetLoader.LoadSurface("Resources/vehicle_diffuse.png");
+		auto normalVehicleSurface = assetLoader.LoadSurface("Resources/vehicle_normal.png");
+		auto glossVehicleSurface = assetLoader.LoadSurface("Resources/vehicle_gloss.png");
+		auto specularVehicleSurface = assetLoader.LoadSurface("Resources/vehicle_specular.png");
+		auto diffuseFireSurface = assetLoader.LoadSurface("Resources/fireFX_diffuse.png");
+
 		//Initialize
 		int width{}, height{};
 		SDL_GetWindowSize(pWindow, &width, &height);
@@ -22,6 +40,9 @@ namespace dae
 		m_pSoftware = new Software{ pWindow, width, height };
 		m_pHardware = new Hardware{ pWindow, width, height };
 
+		// Present a cleared frame so the window is not blank while the assets finish loading.
+		m_pHardware->Render();
+
 		Keybindings();
 
 		const auto device = m_pHardware->GetDevice();
@@ -31,25 +52,23 @@ namespace dae
 		// Initialize Camera.
 		m_Camera.Initialize(45.f, { 0.0f, 0.0f, 0.f }, m_AspectRatio);
 
+		// Both render modes shade with every light of the LightManager, see Update.
 		LightManager::GetInstance().add(new DirectionalLight{ {0.577f, -0.577f, 0.577f}, 7.0f });
+		LightManager::GetInstance().add(new PointLight{ { -10.f, 5.f, 45.f }, 20.f, 120.f });
+		LightManager::GetInstance().add(new PointLight{ { 10.f, 2.f, 40.f }, 15.f, 80.f });
+		LightManager::GetInstance().add(new SpotLight{ { 0.f, 20.f, 50.f }, { 0.f, -1.f, 0.f }, 30.f, 25.f, 40.f, 400.f });
 
-		const auto light = LightManager::GetInstance().GetLights().at(0); // Since we are only adding only one light.
-		m_pSoftware->SetLight(light);
-
-		std::vector<Vertex_In> vertices{};
-		std::vector<uint32_t> indices{};
+		m_pTextureManager = new TextureManager{ device };
 
 		VehicleEffect* pVehicleEffect = new VehicleEffect{ device, L"Resources/PosCol3D.fx" };
-		Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices);
 
-		pVehicleEffect->SetLight(light);
+		m_pDiffuseVehicle = m_pTextureManager->Add("Resources/vehicle_diffuse.png", diffuseVehicleSurface.get());
+		m_pNormalVehicle = m_pTextureManager->Add("Resources/vehicle_normal.png", normalVehicleSurface.get());
+		m_pGlossVehicle = m_pTextureManager->Add("Resources/vehicle_gloss.png", glossVehicleSurface.get());
+		m_pSpecularVehicle = m_pTextureManager->Add("Resources/vehicle_specular.png", specularVehicleSurface.get());
 
-		m_pDiffuseVehicle = new Texture{ "Resources/vehicle_diffuse.png" , device };
-		m_pNormalVehicle = new Texture{ "Resources/vehicle_normal.png" , device };
-		m_pGlossVehicle = new Texture{ "Resources/vehicle_gloss.png" , device };
-		m_pSpecularVehicle = new Texture{ "Resources/vehicle_specular.png" , device };
-
-		m_pVehicleMesh = new Mesh{ device, vertices, indices
+		const MeshData vehicleData{ vehicleMeshData.get() };
+		m_pVehicleMesh = new Mesh{ device, vehicleData.vertices, vehicleData.indices
 			, m_pDiffuseVehicle
 			, m_pNormalVehicle
 			, m_pGlossVehicle
@@ -58,22 +77,43 @@ namespace dae
 
 
 		FireEffect* pFireEffect = new FireEffect{ device, L"Resources/FireShader.fx" };
-		Utils::ParseOBJ("Resources/fireFX.obj", vertices, indices);
 
-		m_pDiffuseFire = new Texture{ "Resources/fireFX_diffuse.png" , device };
+		m_pDiffuseFire = m_pTextureManager->Add("Resources/fireFX_diffuse.png", diffuseFireSurface.get());
 
-		m_pFireMesh = new Mesh{ device, vertices, indices
+		const MeshData fireData{ fireMeshData.get() };
+		m_pFireMesh = new Mesh{ device, fireData.vertices, fireData.indices
 			, m_pDiffuseFire
 			, nullptr
 			, nullptr
 			, nullptr
 			, pFireEffect };
 
+		assetLoader.PrintTimings();
+
 		m_pVehicleMesh->Translate(0.f, 0.f, 50.f);
 		m_pFireMesh->Translate(0.f, 0.f, 50.f);
 
-		m_pSoftware->SetMesh(m_pVehicleMesh);
-		m_pSoftware->SetTextures(m_pDiffuseVehicle, m_pNormalVehicle, m_pGlossVehicle, m_pSpecularVehicle);
+		// Software effects, bound per mesh like the DirectX ones.
+		m_pVehicleSoftwareEffect = new VehicleSoftwareEffect{};
+		m_pVehicleSoftwareEffect->SetTextures(m_pDiffuseVehicle, m_pNormalVehicle, m_pGlossVehicle, m_pSpecularVehicle);
+		m_pVehicleMesh->SetSoftwareEffect(m_pVehicleSoftwareEffect);
+
+		FireSoftwareEffect* pFireSoftwareEffect = new FireSoftwareEffect{};
+		pFireSoftwareEffect->SetDiffuseMap(m_pDiffuseFire);
+		m_pFireMesh->SetSoftwareEffect(pFireSoftwareEffect);
+
+		m_pSoftware->AddMesh(m_pVehicleMesh);
+		m_pSoftware->AddMesh(m_pFireMesh);
+		m_pSoftware->SetShadowCaster(m_pVehicleMesh);
+
+		// The vehicle diffuse is small, but streaming it through a virtual texture exercises the same path a 16k texture would use.
+		const std::string tileFilePath{ "Resources/vehicle_diffuse.vt" };
+		if (!std::ifstream(tileFilePath))
+		{
+			VirtualTexture::BuildTileFile("Resources/vehicle_diffuse.png", tileFilePath);
+		}
+		m_pVirtualDiffuseVehicle = new VirtualTexture{ tileFilePath };
+		m_pVehicleSoftwareEffect->SetVirtualDiffuse(m_pVirtualDiffuseVehicle);
 
 		m_pHardware->SetMeshs(m_pVehicleMesh, m_pFireMesh);
 
@@ -87,20 +127,11 @@ namespace dae
 		delete m_pFireMesh;
 		m_pFireMesh = nullptr;
 
-		delete m_pDiffuseVehicle;
-		m_pDiffuseVehicle = nullptr;
+		delete m_pTextureManager;
+		m_pTextureManager = nullptr;
 
-		delete m_pNormalVehicle;
-		m_pNormalVehicle = nullptr;
-
-		delete m_pGlossVehicle;
-		m_pGlossVehicle = nullptr;
-
-		delete m_pSpecularVehicle;
-		m_pSpecularVehicle = nullptr;
-
-		delete m_pDiffuseFire;
-		m_pDiffuseFire = nullptr;
+		delete m_pVirtualDiffuseVehicle;
+		m_pVirtualDiffuseVehicle = nullptr;
 
 		delete m_pSoftware;
 		m_pSoftware = nullptr;
@@ -121,6 +152,11 @@ namespace dae
 			m_pVehicleMesh->RotateY(45.0f * pTimer->GetElapsed());
 			m_pFireMesh->RotateY(45.0f * pTimer->GetElapsed());
 		}
+
+		// Each mesh only binds the lights that reach it.
+		const auto& lights = LightManager::GetInstance().GetLights();
+		m_VehicleLightCount = m_pVehicleMesh->SetLights(lights);
+		m_pFireMesh->SetLights(lights);
 	}
 
 
@@ -134,13 +170,51 @@ namespace dae
 		{
 			m_pHardware->Render();
 		}
+
+		m_pTextureManager->EndFrame();
+		m_pVirtualDiffuseVehicle->Update();
+	}
+
+	void Renderer::Resize(int width, int height)
+	{
+		// A minimized window reports a size of 0.
+		if (width <= 0 || height <= 0)
+		{
+			return;
+		}
+
+		m_AspectRatio = static_cast<float>(width) / static_cast<float>(height);
+		m_Camera.aspectRatio = m_AspectRatio;
+		m_Camera.CalculateProjectionMatrix();
+
+		m_pSoftware->Resize(width, height);
+		m_pHardware->Resize(width, height);
+	}
+
+	void Renderer::SetStatsEnabled(bool isEnabled) const
+	{
+		m_pSoftware->SetStatsEnabled(isEnabled);
+	}
+
+	void Renderer::PrintStats() const
+	{
+		m_pTextureManager->PrintStats();
+		m_pVirtualDiffuseVehicle->PrintStats();
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pSoftware->PrintStats();
+		}
+		else
+		{
+			std::cout << "Lights reaching the vehicle: " << m_VehicleLightCount << " (" << std::min(m_VehicleLightCount, static_cast<size_t>(VehicleEffect::MaxLights)) << " bound)\n";
+		}
 	}
 
 	void Renderer::CycleFilteringMode() const
 	{
 		if (m_ToggleRenderModeSoftware)
 		{
-			std::cout << "Filtering not Supported in Software mode :(\n";
+			m_pVehicleSoftwareEffect->CycleFilteringMode();
 		}
 		else
 		{
@@ -160,11 +234,23 @@ namespace dae
 		}
 	}
 
+	void Renderer::CycleDepthFormat() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pSoftware->CycleDepthFormat();
+		}
+		else
+		{
+			std::cout << "Depth Format not Supported in Hardware mode :(\n";
+		}
+	}
+
 	void Renderer::CycleShadingMode() const
 	{
 		if (m_ToggleRenderModeSoftware)
 		{
-			m_pSoftware->CycleShadingMode();
+			m_pVehicleSoftwareEffect->CycleShadingMode();
 		}
 		else
 		{
@@ -176,7 +262,7 @@ namespace dae
 	{
 		if (m_ToggleRenderModeSoftware)
 		{
-			m_pSoftware->ToggleNormalMap();
+			m_pVehicleSoftwareEffect->ToggleNormalMap();
 		}
 		else
 		{
@@ -199,19 +285,18 @@ namespace dae
 	void Renderer::SwitchRenderMode()
 	{
 		m_ToggleRenderModeSoftware = !m_ToggleRenderModeSoftware;
+		if (!m_ToggleRenderModeSoftware)
+		{
+			// The swap chain takes the window over once the present thread is done with it.
+			m_pSoftware->WaitForPresents();
+		}
 		std::cout << (m_ToggleRenderModeSoftware ? "Render Mode: Software.\n" : "Render Mode: Hardware.\n");
 	}
 
 	void Renderer::ToggleFireMesh() const
 	{
-		if (m_ToggleRenderModeSoftware)
-		{
-			std::cout << "Toggle Fire Mesh not Supported in Software mode :(\n";
-		}
-		else
-		{
-			m_pHardware->ToggleFireMesh();
-		}
+		m_pHardware->ToggleFireMesh();
+		m_pSoftware->ToggleTransparentMeshes();
 	}
 
 	void Renderer::CycleCullMode() const
@@ -232,31 +317,166 @@ namespace dae
 		m_pSoftware->ToggleUniformBg();
 	}
 
+	void Renderer::ToggleVirtualTexture() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pVehicleSoftwareEffect->ToggleVirtualTexture();
+		}
+		else
+		{
+			std::cout << "Virtual Texture not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::ToggleShadows() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pSoftware->ToggleShadows();
+		}
+		else
+		{
+			std::cout << "Shadows not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::CycleShadingRateMode() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pSoftware->CycleShadingRateMode();
+		}
+		else
+		{
+			std::cout << "Variable Rate Shading not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::CycleFramesInFlight() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pSoftware->CycleFramesInFlight();
+		}
+		else
+		{
+			std::cout << "Frames In Flight not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::TogglePresentMode() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pSoftware->TogglePresentMode();
+		}
+		else
+		{
+			std::cout << "Present Mode not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::ToggleZeroCopyPresent() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pSoftware->ToggleZeroCopyPresent();
+		}
+		else
+		{
+			std::cout << "Zero-Copy Present not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::ToggleDynamicResolution() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pSoftware->ToggleDynamicResolution();
+		}
+		else
+		{
+			std::cout << "Dynamic Resolution not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::ToggleAnisotropyBudget() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pVehicleSoftwareEffect->ToggleAnisotropyBudget();
+		}
+		else
+		{
+			std::cout << "Anisotropy Frame Budget not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::CycleMaxAnisotropy() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			// 2x, 4x, 8x, 16x.
+			const int maxAnisotropy{ m_pVehicleSoftwareEffect->GetMaxAnisotropy() };
+			m_pVehicleSoftwareEffect->SetMaxAnisotropy(maxAnisotropy >= 16 ? 2 : maxAnisotropy * 2);
+			std::cout << "Max Anisotropy: " << m_pVehicleSoftwareEffect->GetMaxAnisotropy() << "x.\n";
+		}
+		else
+		{
+			std::cout << "Max Anisotropy not Supported in Hardware mode :(\n";
+		}
+	}
+
+	void Renderer::CycleSpecularAccuracy() const
+	{
+		if (m_ToggleRenderModeSoftware)
+		{
+			m_pVehicleSoftwareEffect->CycleSpecularAccuracy();
+			// Measured on demand, the report evaluates every accuracy a few million times.
+			m_pVehicleSoftwareEffect->PrintSpecularErrorReport();
+		}
+		else
+		{
+			std::cout << "Cycle Specular Accuracy not Supported in Hardware mode :(\n";
+		}
+	}
+
 	void Renderer::Keybindings() const
 	{
 		std::cout << "[Key Bindings - SHARED]\n";
 		std::cout << "[F1] Switch Render Mode (Hardware / Software).\n";
 		std::cout << "[F2] Toggle Vehicle Rotation (ON / OFF).\n";
+		std::cout << "[F3] Toggle Fire Mesh (ON / OFF).\n";
+		std::cout << "[F4] Cycle Filtering Mode (Point / Linear / Anisotropic).\n";
 		std::cout << "[F9] Cycle CullMode (Back / None / Front).\n";
 		std::cout << "[F10] Toggle Uniform ClearColor (ON / OFF).\n";
 		std::cout << "[F11] Toggle Print FPS (ON / OFF).\n";
 		std::cout << "\n";
 
-		std::cout << "[Key Bindings - HARDWARE]\n";
-		std::cout << "[F3] Toggle Fire Mesh (ON / OFF).\n";
-		std::cout << "[F4] Cycle Filtering Mode (Point / Linear / Anisotropic).\n";
-		std::cout << "\n";
-
 		std::cout << "[Key Bindings - SOFTWARE]\n";
 		std::cout << "[F5] Switch Shading Mode (Combined / Observed Area / Diffuse / Specular).\n";
 		std::cout << "[F6] Toggle NormalMap (ON / OFF).\n";
 		std::cout << "[F7] Toggle Depth Buffer Visualization (ON / OFF).\n";
 		std::cout << "[F8] Toggle Bounding Box Visualization (ON / OFF).\n";
+		std::cout << "[V] Toggle Virtual Texture Diffuse (ON / OFF).\n";
+		std::cout << "[A] Cycle Max Anisotropy (2x / 4x / 8x / 16x).\n";
+		std::cout << "[B] Toggle Anisotropy Frame Budget (ON / OFF).\n";
+		std::cout << "[P] Cycle Specular Accuracy (Exact / Fast / Lookup Table) and print their error.\n";
+		std::cout << "[H] Toggle Shadows (ON / OFF).\n";
+		std::cout << "[R] Cycle Shading Rate (Full / Coarse 2x2 / By Distance / By Luminance Gradient).\n";
+		std::cout << "[L] Cycle Frames In Flight (1 / 2 / 3).\n";
+		std::cout << "[M] Toggle Present Mode (FIFO / Mailbox).\n";
+		std::cout << "[C] Toggle Zero-Copy Present (ON / OFF).\n";
+		std::cout << "[G] Toggle Dynamic Resolution (ON / OFF).\n";
+		std::cout << "[Z] Cycle Depth Format (Float32 / Reversed-Z Float32 / Unorm24 / Unorm16).\n";
 		std::cout << "\n";
 
 		std::cout << "[Features Added]\n";
 		std::cout << "Multithreading.\n";
 		std::cout << "Directional light and Manager.\n";
+		std::cout << "Clustered light culling (Software).\n";
+		std::cout << "Point and spot lights.\n";
 		std::cout << "[E] Local Up.\n";
 		std::cout << "[Q] Local Down.\n";
 		std::cout << "\n";
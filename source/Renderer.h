@@ -9,6 +9,10 @@ struct SDL_Surface;
 
 namespace dae
 {
+	class TextureManager;
+	class VehicleSoftwareEffect;
+	class VirtualTexture;
+
 	class Renderer final
 	{
 	public:
@@ -22,8 +26,13 @@ namespace dae
 
 		void Update(const Timer* pTimer);
 		void Render() const;
+		// Called on a resize of the window, with its new client size.
+		void Resize(int width, int height);
+		void PrintStats() const;
+		void SetStatsEnabled(bool isEnabled) const;
 		void CycleFilteringMode() const;
 		void VisualizeDepthBuffer() const;
+		void CycleDepthFormat() const;
 		void CycleShadingMode() const;
 		void ToggleNormalMap() const;
 		void ToggleBoundingBox() const;
@@ -32,6 +41,16 @@ namespace dae
 		void CycleCullMode() const;
 		void ToggleRotation();
 		void ToggleUniformBg() const;
+		void ToggleVirtualTexture() const;
+		void ToggleShadows() const;
+		void CycleShadingRateMode() const;
+		void CycleFramesInFlight() const;
+		void TogglePresentMode() const;
+		void ToggleZeroCopyPresent() const;
+		void ToggleDynamicResolution() const;
+		void ToggleAnisotropyBudget() const;
+		void CycleMaxAnisotropy() const;
+		void CycleSpecularAccuracy() const;
 
 	private:
 
@@ -40,14 +59,20 @@ namespace dae
 
 		Mesh* m_pVehicleMesh;
 		Mesh* m_pFireMesh;
+		// Owned by the vehicle mesh.
+		VehicleSoftwareEffect* m_pVehicleSoftwareEffect;
 		Camera m_Camera{};
 		float m_AspectRatio{};
+		size_t m_VehicleLightCount{};
 
+		// Owned by the texture manager.
+		TextureManager* m_pTextureManager;
 		Texture* m_pDiffuseVehicle;
 		Texture* m_pNormalVehicle;
 		Texture* m_pGlossVehicle;
 		Texture* m_pSpecularVehicle;
 		Texture* m_pDiffuseFire;
+		VirtualTexture* m_pVirtualDiffuseVehicle;
 
 		bool m_ToggleRenderModeSoftware{ false };
 		bool m_ToggleRotation{ true };
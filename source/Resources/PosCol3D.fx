@@ -15,13 +15,22 @@ Texture2D gGlossMap : GlossMap;
 
 // float global variables.
 float gPI = float(3.1415926f);
-float gLightIntensity;
 float gSpecularShininess = float(25.0f);
 
 // float3 global variables.
-float3 gLightDirection;
 float3 gAmbient = float3(0.025f, 0.025f, 0.025f);
 
+// Light global variables, same layout and limit as VehicleEffect::SetLights.
+#define MAX_LIGHTS 8
+#define LIGHT_DIRECTIONAL 0
+#define LIGHT_POINT 1
+#define LIGHT_SPOT 2
+
+int gLightCount;
+float4 gLightPositions[MAX_LIGHTS]; // xyz position, w range.
+float4 gLightDirections[MAX_LIGHTS]; // xyz direction, w type.
+float4 gLightParameters[MAX_LIGHTS]; // x intensity, y inner cone cosine, z outer cone cosine.
+
 // SamplerState global variable.
 SamplerState gSampleState
 {
@@ -114,6 +123,20 @@ float LambertCosineLaw(float3 n, float3 l)
     return max(0.0f, dot(n, -l));
 }
 
+// Inverse square falloff, windowed so it reaches 0 at the range (same as Lights::GetDistanceAttenuation).
+float DistanceAttenuation(float distance, float range)
+{
+    float ratio = distance / range;
+    float window = saturate(1.0f - ratio * ratio * ratio * ratio);
+    return window * window / (distance * distance + 1.0f);
+}
+
+float ConeAttenuation(float cosAngle, float innerConeCos, float outerConeCos)
+{
+    float fade = saturate((cosAngle - outerConeCos) / max(innerConeCos - outerConeCos, 1e-4f));
+    return fade * fade;
+}
+
 //----------
 // Vertex Shader.
 //----------
@@ -128,7 +151,7 @@ VS_OUTPUT VS(VS_INPUT input)
     output.Normal = mul(normalize(input.Normal), (float3x3)gWorldMatrix);
     //output.Tangent = -mul(normalize(input.Tangent), (float3x3)gWorldMatrix);
     output.Tangent = mul(normalize(input.Tangent), (float3x3)gWorldMatrix);
-    output.WorldPosition = mul(input.Position, gWorldMatrix);
+    output.WorldPosition = mul(float4(input.Position, 1.0f), gWorldMatrix);
     return output;
 }
 
@@ -146,22 +169,40 @@ float4 PS(VS_OUTPUT input) : SV_TARGET
     float3 tangentSpaceVector = input.Normal;
     tangentSpaceVector = normalize(mul(normalMapCol, tangentSpaceMatrix)); // just comment this part out if you dont want normal map.
     
-    float lambertCosineLaw = LambertCosineLaw(tangentSpaceVector, gLightDirection);
-    if(lambertCosineLaw < 0.0f)
-    {
-        return float4(0.0f, 0.0f, 0.0f, 1.0f);
-    }
     float3 viewDirection = normalize(input.WorldPosition.xyz - gViewInvMatrix[3].xyz);
 
     float specularExp = gSpecularShininess * gGlossMap.Sample(gSampleState, input.Uv).x;
-    float3 specular = Phong(gSpecularMap.Sample(gSampleState, input.Uv), 1.0f, specularExp, gLightDirection, viewDirection, tangentSpaceVector);
-
+    float3 specularColor = gSpecularMap.Sample(gSampleState, input.Uv).rgb;
     float3 lambert = Lambert(1.0f, gDiffuseMap.Sample(gSampleState, input.Uv));
 
-    //return float4(lambert * lambertCosineLaw * gLightIntensity, 1.0f); // lambert final.
-    //return float4(specular, 1.0f); // specular final.
-    //return float4(lambertCosineLaw, lambertCosineLaw, lambertCosineLaw, 1.0f); // observed area final.
-    return float4(((lambert * gLightIntensity) + specular) * lambertCosineLaw, 1.0f) + float4(gAmbient, 0.0f);
+    float3 finalColor = gAmbient;
+    for (int i = 0; i < gLightCount; ++i)
+    {
+        float3 lightDirection = gLightDirections[i].xyz;
+        float falloff = 1.0f;
+        if (gLightDirections[i].w != LIGHT_DIRECTIONAL)
+        {
+            float3 toPixel = input.WorldPosition.xyz - gLightPositions[i].xyz;
+            float distance = length(toPixel);
+            lightDirection = toPixel / max(distance, 1e-6f);
+            falloff = DistanceAttenuation(distance, gLightPositions[i].w);
+
+            if (gLightDirections[i].w == LIGHT_SPOT)
+            {
+                falloff *= ConeAttenuation(dot(lightDirection, gLightDirections[i].xyz), gLightParameters[i].y, gLightParameters[i].z);
+            }
+        }
+
+        float lambertCosineLaw = LambertCosineLaw(tangentSpaceVector, lightDirection);
+        float3 specular = Phong(specularColor, 1.0f, specularExp, lightDirection, viewDirection, tangentSpaceVector) * falloff;
+
+        //finalColor += lambert * lambertCosineLaw * gLightParameters[i].x * falloff; // lambert final.
+        //finalColor += specular; // specular final.
+        //finalColor += lambertCosineLaw; // observed area final.
+        finalColor += ((lambert * gLightParameters[i].x * falloff) + specular) * lambertCosineLaw;
+    }
+
+    return float4(finalColor, 1.0f);
 }
 
 //----------
@@ -0,0 +1,253 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+#include <emmintrin.h> // SSE2
+#include "Texture.h"
+#include "Vector2.h"
+
+namespace dae
+{
+	// Same options as the AddressU/AddressV fields of a D3D11 sampler.
+	enum class AddressMode
+	{
+		Wrap, Clamp, Mirror, Border
+	};
+
+	enum class FilterMode
+	{
+		Point, Bilinear
+	};
+
+	enum class TextureSize
+	{
+		Any, PowerOfTwo
+	};
+
+	// Software sampler state resolved at compile time.
+	// Every address/filter combination is its own specialization, so sampling does not branch on the sampler state.
+	// Use TextureSize::PowerOfTwo only for textures where Texture::IsPowerOfTwo() is true, wrapping then becomes a bitmask.
+	template<AddressMode Address, FilterMode Filter, TextureSize Size = TextureSize::Any>
+	struct Sampler final
+	{
+		static ColorRGB Sample(const Texture& texture, const Vector2& uv, int level = 0)
+		{
+			assert(Size == TextureSize::Any || texture.IsPowerOfTwo());
+
+			const Texture::MipLevel& mip{ texture.AcquireLevel(level) };
+			const int width{ mip.width };
+			const int height{ mip.height };
+
+			if constexpr (Filter == FilterMode::Point)
+			{
+				const int x{ static_cast<int>(std::floor(uv.x * static_cast<float>(width))) };
+				const int y{ static_cast<int>(std::floor(uv.y * static_cast<float>(height))) };
+
+				return Fetch(texture, mip, x, y, width, height);
+			}
+			else
+			{
+				// Texel centers are at half coordinates.
+				const float u{ uv.x * static_cast<float>(width) - 0.5f };
+				const float v{ uv.y * static_cast<float>(height) - 0.5f };
+				const float floorU{ std::floor(u) };
+				const float floorV{ std::floor(v) };
+				const float fracU{ u - floorU };
+				const float fracV{ v - floorV };
+				const int x{ static_cast<int>(floorU) };
+				const int y{ static_cast<int>(floorV) };
+
+				const ColorRGB top{ ColorRGB::Lerp(Fetch(texture, mip, x, y, width, height), Fetch(texture, mip, x + 1, y, width, height), fracU) };
+				const ColorRGB bottom{ ColorRGB::Lerp(Fetch(texture, mip, x, y + 1, width, height), Fetch(texture, mip, x + 1, y + 1, width, height), fracU) };
+				return ColorRGB::Lerp(top, bottom, fracV);
+			}
+		}
+
+		// Alpha of the texel Sample picks.
+		static float SampleAlpha(const Texture& texture, const Vector2& uv, int level = 0)
+		{
+			static_assert(Filter == FilterMode::Point, "SampleAlpha only supports point filtering.");
+			assert(Size == TextureSize::Any || texture.IsPowerOfTwo());
+
+			const Texture::MipLevel& mip{ texture.AcquireLevel(level) };
+			const int x{ static_cast<int>(std::floor(uv.x * static_cast<float>(mip.width))) };
+			const int y{ static_cast<int>(std::floor(uv.y * static_cast<float>(mip.height))) };
+
+			if constexpr (Address == AddressMode::Border)
+			{
+				if (static_cast<unsigned int>(x) >= static_cast<unsigned int>(mip.width) || static_cast<unsigned int>(y) >= static_cast<unsigned int>(mip.height))
+				{
+					return 0.f;
+				}
+				return texture.GetTexelAlpha(mip, x, y);
+			}
+			else
+			{
+				return texture.GetTexelAlpha(mip, ResolveCoordinate(x, mip.width), ResolveCoordinate(y, mip.height));
+			}
+		}
+
+		// Single texel at integer coordinates of a mip level, addressed with this sampler's mode.
+		static ColorRGB Fetch(const Texture& texture, const Texture::MipLevel& mip, int x, int y, int width, int height)
+		{
+			if constexpr (Address == AddressMode::Border)
+			{
+				// Unsigned compare catches negative coordinates as well.
+				if (static_cast<unsigned int>(x) >= static_cast<unsigned int>(width) || static_cast<unsigned int>(y) >= static_cast<unsigned int>(height))
+				{
+					return colors::Black;
+				}
+				return texture.GetTexel(mip, x, y);
+			}
+			else
+			{
+				return texture.GetTexel(mip, ResolveCoordinate(x, width), ResolveCoordinate(y, height));
+			}
+		}
+
+	private:
+
+		static int ResolveCoordinate(int coordinate, int size)
+		{
+			if constexpr (Address == AddressMode::Wrap)
+			{
+				if constexpr (Size == TextureSize::PowerOfTwo)
+				{
+					// Two's complement makes this correct for negative coordinates too.
+					return coordinate & (size - 1);
+				}
+				else
+				{
+					const int wrapped{ coordinate % size };
+					return wrapped + (wrapped < 0 ? size : 0);
+				}
+			}
+			else if constexpr (Address == AddressMode::Clamp)
+			{
+				return std::clamp(coordinate, 0, size - 1);
+			}
+			else
+			{
+				// Mirror: repeat with a period of twice the size, the second half reversed.
+				const int period{ 2 * size };
+				int wrapped;
+				if constexpr (Size == TextureSize::PowerOfTwo)
+				{
+					wrapped = coordinate & (period - 1);
+				}
+				else
+				{
+					wrapped = coordinate % period;
+					wrapped += (wrapped < 0 ? period : 0);
+				}
+				return std::min(wrapped, period - 1 - wrapped);
+			}
+		}
+	};
+
+	// Level of detail for an isotropic footprint, uvDdx and uvDdy are the UV differences to the neighbouring pixels.
+	inline float CalculateLod(int width, int height, const Vector2& uvDdx, const Vector2& uvDdy)
+	{
+		const Vector2 ddx{ uvDdx.x * static_cast<float>(width), uvDdx.y * static_cast<float>(height) };
+		const Vector2 ddy{ uvDdy.x * static_cast<float>(width), uvDdy.y * static_cast<float>(height) };
+		const float footprint{ std::max(ddx.SqrMagnitude(), ddy.SqrMagnitude()) };
+		return std::max(0.f, 0.5f * std::log2(std::max(footprint, 1.f)));
+	}
+
+	// Footprint based anisotropic filter on top of the mip chain.
+	// Bilinear taps are spread along the major axis of the pixel footprint, the mip level is picked from the minor axis.
+	// The tap positions and bilinear weights are computed 4 taps at a time with SSE.
+	template<AddressMode Address, TextureSize Size = TextureSize::Any>
+	struct AnisotropicSampler final
+	{
+		static constexpr int MaxTaps{ 16 };
+
+		static ColorRGB Sample(const Texture& texture, const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy, int maxTaps)
+		{
+			using TexelSampler = Sampler<Address, FilterMode::Point, Size>;
+
+			// Footprint in texels of level 0.
+			const float textureWidth{ static_cast<float>(texture.GetWidth()) };
+			const float textureHeight{ static_cast<float>(texture.GetHeight()) };
+			const float lengthX{ Vector2{ uvDdx.x * textureWidth, uvDdx.y * textureHeight }.Magnitude() };
+			const float lengthY{ Vector2{ uvDdy.x * textureWidth, uvDdy.y * textureHeight }.Magnitude() };
+
+			const bool isMajorX{ lengthX >= lengthY };
+			const float majorLength{ isMajorX ? lengthX : lengthY };
+			const float minorLength{ std::max(isMajorX ? lengthY : lengthX, 1e-6f) };
+			const Vector2 majorAxis{ isMajorX ? uvDdx : uvDdy };
+
+			const int taps{ std::clamp(static_cast<int>(std::ceil(majorLength / minorLength)), 1, std::clamp(maxTaps, 1, MaxTaps)) };
+			const float lod{ std::log2(std::max(majorLength / static_cast<float>(taps), 1.f)) };
+
+			const Texture::MipLevel& mip{ texture.AcquireLevel(static_cast<int>(lod + 0.5f)) };
+			const int width{ mip.width };
+			const int height{ mip.height };
+
+			const __m128 half{ _mm_set1_ps(0.5f) };
+			const __m128 one{ _mm_set1_ps(1.f) };
+			const __m128 tapCount{ _mm_set1_ps(static_cast<float>(taps)) };
+			const __m128 inverseTapCount{ _mm_set1_ps(1.f / static_cast<float>(taps)) };
+			const __m128 laneOffsets{ _mm_setr_ps(0.f, 1.f, 2.f, 3.f) };
+
+			alignas(16) int texelX[4];
+			alignas(16) int texelY[4];
+			alignas(16) float weights[4][4];
+
+			__m128 sum{ _mm_setzero_ps() };
+			for (int firstTap = 0; firstTap < taps; firstTap += 4)
+			{
+				// Tap positions spread evenly over [-0.5, 0.5] of the major axis.
+				const __m128 tapIndex{ _mm_add_ps(_mm_set1_ps(static_cast<float>(firstTap)), laneOffsets) };
+				const __m128 t{ _mm_sub_ps(_mm_mul_ps(_mm_add_ps(tapIndex, half), inverseTapCount), half) };
+				const __m128 isActive{ _mm_cmplt_ps(tapIndex, tapCount) };
+
+				// Texel space, centers at half coordinates.
+				const __m128 u{ _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(uv.x), _mm_mul_ps(_mm_set1_ps(majorAxis.x), t)), _mm_set1_ps(static_cast<float>(width))), half) };
+				const __m128 v{ _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(uv.y), _mm_mul_ps(_mm_set1_ps(majorAxis.y), t)), _mm_set1_ps(static_cast<float>(height))), half) };
+
+				const __m128 floorU{ Floor(u) };
+				const __m128 floorV{ Floor(v) };
+				const __m128 fracU{ _mm_sub_ps(u, floorU) };
+				const __m128 fracV{ _mm_sub_ps(v, floorV) };
+				const __m128 inverseFracU{ _mm_sub_ps(one, fracU) };
+				const __m128 inverseFracV{ _mm_sub_ps(one, fracV) };
+
+				_mm_store_si128(reinterpret_cast<__m128i*>(texelX), _mm_cvttps_epi32(floorU));
+				_mm_store_si128(reinterpret_cast<__m128i*>(texelY), _mm_cvttps_epi32(floorV));
+				_mm_store_ps(weights[0], _mm_and_ps(_mm_mul_ps(inverseFracU, inverseFracV), isActive));
+				_mm_store_ps(weights[1], _mm_and_ps(_mm_mul_ps(fracU, inverseFracV), isActive));
+				_mm_store_ps(weights[2], _mm_and_ps(_mm_mul_ps(inverseFracU, fracV), isActive));
+				_mm_store_ps(weights[3], _mm_and_ps(_mm_mul_ps(fracU, fracV), isActive));
+
+				const int activeTaps{ std::min(4, taps - firstTap) };
+				for (int lane = 0; lane < activeTaps; ++lane)
+				{
+					const int x{ texelX[lane] };
+					const int y{ texelY[lane] };
+					sum = _mm_add_ps(sum, _mm_mul_ps(ToVector(TexelSampler::Fetch(texture, mip, x, y, width, height)), _mm_set1_ps(weights[0][lane])));
+					sum = _mm_add_ps(sum, _mm_mul_ps(ToVector(TexelSampler::Fetch(texture, mip, x + 1, y, width, height)), _mm_set1_ps(weights[1][lane])));
+					sum = _mm_add_ps(sum, _mm_mul_ps(ToVector(TexelSampler::Fetch(texture, mip, x, y + 1, width, height)), _mm_set1_ps(weights[2][lane])));
+					sum = _mm_add_ps(sum, _mm_mul_ps(ToVector(TexelSampler::Fetch(texture, mip, x + 1, y + 1, width, height)), _mm_set1_ps(weights[3][lane])));
+				}
+			}
+
+			alignas(16) float color[4];
+			_mm_store_ps(color, _mm_mul_ps(sum, inverseTapCount));
+			return { color[0], color[1], color[2] };
+		}
+
+	private:
+
+		// SSE2 has no floor, truncate and correct the negative values.
+		static __m128 Floor(__m128 value)
+		{
+			const __m128 truncated{ _mm_cvtepi32_ps(_mm_cvttps_epi32(value)) };
+			return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.f)));
+		}
+
+		static __m128 ToVector(const ColorRGB& color)
+		{
+			return _mm_setr_ps(color.r, color.g, color.b, 0.f);
+		}
+	};
+}
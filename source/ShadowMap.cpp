@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "ShadowMap.h"
+
+namespace dae
+{
+	namespace
+	{
+		bool IsSameMatrix(const Matrix& a, const Matrix& b)
+		{
+			for (int row = 0; row < 4; ++row)
+			{
+				for (int column = 0; column < 4; ++column)
+				{
+					if (a[row][column] != b[row][column])
+					{
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+	}
+
+	ShadowMap::ShadowMap()
+		: m_Bins(Resolution, Resolution)
+	{
+		m_Depth.resize(static_cast<size_t>(Resolution) * Resolution);
+	}
+
+	bool ShadowMap::Update(const Vector3& lightDirection, const Matrix& casterWorldMatrix, const Vector3& casterCenter, float casterRadius)
+	{
+		if (m_IsValid && IsSameMatrix(casterWorldMatrix, m_CasterWorldMatrix)
+			&& lightDirection.x == m_LightDirection.x && lightDirection.y == m_LightDirection.y && lightDirection.z == m_LightDirection.z)
+		{
+			++m_CachedFrames;
+			return false;
+		}
+
+		m_IsValid = true;
+		m_LightDirection = lightDirection;
+		m_CasterWorldMatrix = casterWorldMatrix;
+		++m_RenderedFrames;
+
+		// The light looks along its direction from just outside the sphere, the box spans the sphere in x and y and its diameter in depth.
+		const Vector3 forward{ lightDirection.Normalized() };
+		Vector3 up{}, right{};
+		const Matrix lightView{ Matrix::CreateLookAtLH(casterCenter - forward * casterRadius, forward, up, right).Inverse() };
+		const Matrix orthographic{
+			Vector4(1.f / casterRadius, 0, 0, 0),
+			Vector4(0, 1.f / casterRadius, 0, 0),
+			Vector4(0, 0, 0.5f / casterRadius, 0),
+			Vector4(0, 0, 0, 1) };
+		m_LightViewProjection = lightView * orthographic;
+
+		return true;
+	}
+
+	float ShadowMap::SampleVisibility(const Vector3& worldPosition) const
+	{
+		const Vector3 lightPosition{ m_LightViewProjection.TransformPoint(worldPosition) };
+		if (lightPosition.x < -1.f || lightPosition.x > 1.f || lightPosition.y < -1.f || lightPosition.y > 1.f || lightPosition.z > 1.f)
+		{
+			return 1.f;
+		}
+
+		// Same NDC to raster mapping as the rasterizer, the kernel is centered on the texel.
+		const int x{ static_cast<int>((lightPosition.x + 1.f) * 0.5f * static_cast<float>(Resolution)) - PcfSize / 2 + 1 };
+		const int y{ static_cast<int>((1.f - lightPosition.y) * 0.5f * static_cast<float>(Resolution)) - PcfSize / 2 + 1 };
+		const int firstX{ std::clamp(x, 0, Resolution - PcfSize) };
+
+		// Two texels of depth bias against acne on surfaces at an angle to the light, the box is as deep as it is wide.
+		constexpr float depthBias{ 2.f / static_cast<float>(Resolution) };
+		const __m128 receiverDepth{ _mm_set1_ps(lightPosition.z - depthBias) };
+		const __m128 one{ _mm_set1_ps(1.f) };
+
+		__m128 litTaps{ _mm_setzero_ps() };
+		for (int row = 0; row < PcfSize; ++row)
+		{
+			const int tapY{ std::clamp(y + row, 0, Resolution - 1) };
+			const __m128 occluderDepth{ _mm_loadu_ps(m_Depth.data() + tapY * Resolution + firstX) };
+			litTaps = _mm_add_ps(litTaps, _mm_and_ps(_mm_cmple_ps(receiverDepth, occluderDepth), one));
+		}
+
+		// Horizontal sum of the four lanes.
+		litTaps = _mm_add_ps(litTaps, _mm_shuffle_ps(litTaps, litTaps, _MM_SHUFFLE(2, 3, 0, 1)));
+		litTaps = _mm_add_ps(litTaps, _mm_shuffle_ps(litTaps, litTaps, _MM_SHUFFLE(1, 0, 3, 2)));
+		return _mm_cvtss_f32(litTaps) / static_cast<float>(PcfSize * PcfSize);
+	}
+
+	void ShadowMap::PrintStats() const
+	{
+		std::cout << "Shadow Map: " << Resolution << "x" << Resolution
+			<< " | Rendered: " << m_RenderedFrames << " frames | Cached: " << m_CachedFrames << " frames\n";
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <emmintrin.h> // SSE2
+#include "Math.h"
+#include "TileBinner.h"
+
+namespace dae
+{
+	// Depth seen from a directional light, over an orthographic box fitted around the bounding sphere of the shadow casters.
+	// The depth is only rendered again when the light or a caster moved, otherwise the map of the last frame is reused.
+	class ShadowMap final
+	{
+	public:
+
+		static constexpr int Resolution{ 1024 };
+		// PCF kernel is PcfSize x PcfSize texels, one SSE row of 4 taps at a time.
+		static constexpr int PcfSize{ 4 };
+		static_assert(PcfSize == 4, "A PCF row is one SSE register.");
+
+		ShadowMap();
+
+		// Refits the light box, true when the depth is out of date and has to be rendered.
+		bool Update(const Vector3& lightDirection, const Matrix& casterWorldMatrix, const Vector3& casterCenter, float casterRadius);
+		// Forces a render on the next Update.
+		void Invalidate() { m_IsValid = false; }
+
+		const Matrix& GetLightViewProjection() const { return m_LightViewProjection; }
+		float* GetDepth() { return m_Depth.data(); }
+		TileBinner& GetBins() { return m_Bins; }
+
+		// Fraction of the PCF taps around the world position that see the light, 1 outside the map.
+		float SampleVisibility(const Vector3& worldPosition) const;
+
+		// How often the depth was rendered and how often the cached one was reused.
+		void PrintStats() const;
+
+	private:
+
+		std::vector<float> m_Depth{};
+		TileBinner m_Bins;
+		Matrix m_LightViewProjection{};
+
+		// What the cached depth was rendered for.
+		bool m_IsValid{ false };
+		Vector3 m_LightDirection{};
+		Matrix m_CasterWorldMatrix{};
+
+		int m_RenderedFrames{};
+		int m_CachedFrames{};
+	};
+}
@@ -1,383 +1,805 @@
 #include "pch.h"
 #include "Software.h"
-#include <ppl.h> // parallel_for
 
-#include <array>
+#include <chrono>
 
-#include "BRDFs.h"
 #include "Vertex.h"
+#include "LightManager.h"
+#include "SoftwareRaster.h"
+#include "JobSystem.h"
+#include "AllocationCounter.h"
 
 namespace dae
 {
+	Software::Frame::Frame(int slot, int width, int height, uint32_t pixelFormat)
+		: slot(slot)
+		, lights(width, height)
+	{
+		pBackBuffer = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, pixelFormat);
+		pTarget = pBackBuffer;
+	}
+
 	Software::Software(SDL_Window* pWindow, int width, int height)
 		: m_pWindow(pWindow)
 		, m_Width(width)
 		, m_Height(height)
+		, m_ColorBuffer(width, height)
 	{
 		//Create Buffers software.
-		m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-		m_pBackBufferPixels = static_cast<uint32_t*>(m_pBackBuffer->pixels);
-		m_pDepthBufferPixels = new float[m_Width * m_Height];
+		// In the window's format when it is 32 bit, so presenting is a plain copy.
+		const SDL_PixelFormat* pWindowFormat{ SDL_GetWindowSurface(pWindow)->format };
+		m_SurfaceFormat = pWindowFormat->BytesPerPixel == 4 ? pWindowFormat->format : static_cast<uint32_t>(SDL_PIXELFORMAT_RGB888);
+		CreateBuffers();
+		m_pPresenter = new Presenter{ pWindow };
+		m_PixelFormat = PixelFormat::FromSurfaceFormat(*m_pFrames[0]->pBackBuffer->format);
 
 	}
 
 	Software::~Software()
 	{
-		delete[] m_pDepthBufferPixels;
-		m_pDepthBufferPixels = nullptr;
+		// Stops presenting before the back buffers go away.
+		delete m_pPresenter;
+		m_pPresenter = nullptr;
+
+		DestroyBuffers();
 	}
 
-	void Software::Render(const Camera& camera) const
+	void Software::Resize(int width, int height)
 	{
-		//@START
-		//Lock BackBuffer
-		SDL_LockSurface(m_pBackBuffer);
-
-		// Main Mesh vector.
-		std::vector<Mesh*> meshes_world{};
-		meshes_world.emplace_back(m_pVehicleMesh);
+		if (width == m_Width && height == m_Height)
+		{
+			return;
+		}
 
-		VertexTransformationFunction(meshes_world, camera);
+		// Frames still in flight were set up for the old size, they are dropped instead of presented stretched.
+		m_pPresenter->Flush();
+		DestroyBuffers();
 
-		std::fill_n(m_pDepthBufferPixels, m_Width * m_Height, FLT_MAX);
+		m_Width = width;
+		m_Height = height;
+		m_ColorBuffer.Resize(m_Width, m_Height);
+		CreateBuffers();
+		m_pPresenter->Resize();
 
-		UINT8 color;
-		m_UniformBg ? color = 25 : color = 100;
-		SDL_FillRect(m_pBackBuffer, NULL, SDL_MapRGB(m_pBackBuffer->format, color, color, color));
+		std::cout << "Software Resolution: " << m_Width << 'x' << m_Height << ".\n";
+	}
 
-		//RENDER LOGIC
-		for (const auto& mesh : meshes_world)
+	void Software::CreateBuffers()
+	{
+		for (int slot = 0; slot < MaxFramesInFlight; ++slot)
 		{
-			if (mesh->m_PrimitiveTopology == Mesh::PrimitiveTopology::TriangleList)
-			{
-				concurrency::parallel_for(static_cast<size_t>(0), mesh->m_Indices.size(), static_cast<size_t>(3), [=](const size_t i)
-				{
-					Vertex_Out v0{ mesh->m_VerticesOut[mesh->m_Indices[i]] };
-					Vertex_Out v1{ mesh->m_VerticesOut[mesh->m_Indices[i + 1]] };
-					Vertex_Out v2{ mesh->m_VerticesOut[mesh->m_Indices[i + 2]] };
-
-					// Clipping.
-					if (v0.position.x < -1 || v0.position.x > 1 ||
-						v0.position.y < -1 || v0.position.y > 1)
-					{
-						return;
-					}
+			m_pFrames[slot] = new Frame{ slot, m_Width, m_Height, m_SurfaceFormat };
+		}
+		// Same row pitch as the color buffer, so both index a pixel alike. Sized for the widest depth format, a narrower one uses the front of it.
+		m_pDepthBuffer = new std::byte[static_cast<size_t>(m_ColorBuffer.GetStride()) * m_Height * sizeof(float)];
+	}
 
-					if (v1.position.x < -1 || v1.position.x > 1 ||
-						v1.position.y < -1 || v1.position.y > 1)
-					{
-						return;
-					}
+	void Software::DestroyBuffers()
+	{
+		delete[] m_pDepthBuffer;
+		m_pDepthBuffer = nullptr;
 
-					if (v2.position.x < -1 || v2.position.x > 1 ||
-						v2.position.y < -1 || v2.position.y > 1)
-					{
-						return;
-					}
+		for (Frame*& pFrame : m_pFrames)
+		{
+			SDL_FreeSurface(pFrame->pBackBuffer);
+			delete pFrame;
+			pFrame = nullptr;
+		}
+		m_pStatsFrame = nullptr;
+	}
 
-					// NDC to raster.
-					v0.position.x = ((v0.position.x + 1) / 2) * static_cast<float>(m_Width);
-					v0.position.y = ((1 - v0.position.y) / 2) * static_cast<float>(m_Height);
+	void Software::Render(const Camera& camera)
+	{
+		JobSystem& jobSystem{ JobSystem::GetInstance() };
+		const uint64_t allocationCount{ GetAllocationCount() };
 
-					v1.position.x = ((v1.position.x + 1) / 2) * static_cast<float>(m_Width);
-					v1.position.y = ((1 - v1.position.y) / 2) * static_cast<float>(m_Height);
+		UpdateResolutionScale();
 
-					v2.position.x = ((v2.position.x + 1) / 2) * static_cast<float>(m_Width);
-					v2.position.y = ((1 - v2.position.y) / 2) * static_cast<float>(m_Height);
+		Frame& frame{ *m_pFrames[m_FrameNumber % MaxFramesInFlight] };
+		Frame& previousFrame{ *m_pFrames[(m_FrameNumber + MaxFramesInFlight - 1) % MaxFramesInFlight] };
+		Frame& olderFrame{ *m_pFrames[(m_FrameNumber + MaxFramesInFlight - 2) % MaxFramesInFlight] };
 
-					PixelRenderLoop(v0, v1, v2);
-				});
+		// The previous frame rasterizes while this one runs its vertex stage.
+		// Its effects are set up here, while no other stage is running, and keep that setup until the raster job is done.
+		JobSystem::JobHandle rasterJob{};
+		if (previousFrame.stage == FrameStage::Recorded)
+		{
+			BeginRaster(previousFrame);
+			rasterJob = jobSystem.Schedule([this, &previousFrame] { RasterizeFrame(previousFrame); });
+		}
 
-			}
-			else if (mesh->m_PrimitiveTopology == Mesh::PrimitiveTopology::TriangleStrip)
-			{
-				concurrency::parallel_for(static_cast<size_t>(0), mesh->m_Indices.size() - 2, [=](const size_t i)
-				{
-					uint32_t index1{ mesh->m_Indices[i] };
-					uint32_t index2{ mesh->m_Indices[i + 1] };
-					uint32_t index3{ mesh->m_Indices[i + 2] };
+		// With three frames in flight the one before is presented meanwhile.
+		if (olderFrame.stage == FrameStage::Rasterized)
+		{
+			PresentFrame(olderFrame);
+		}
 
-					if (index3 % 2 == 1)
-					{
-						index2 = mesh->m_Indices[i + 2];
-						index3 = mesh->m_Indices[i + 1];
-					}
+		assert(frame.stage == FrameStage::Free && "A frame slot is reused while still in flight.");
+		frame.number = ++m_FrameNumber;
+		RecordGeometry(frame, camera);
 
-					Vertex_Out v0{ mesh->m_VerticesOut[index1] };
-					Vertex_Out v1{ mesh->m_VerticesOut[index2] };
-					Vertex_Out v2{ mesh->m_VerticesOut[index3] };
+		if (rasterJob)
+		{
+			jobSystem.Wait(rasterJob);
+		}
 
-					PixelRenderLoop(v0, v1, v2);
-				});
-			}
+		if (m_FramesInFlight == 1)
+		{
+			BeginRaster(frame);
+			RasterizeFrame(frame);
+			PresentFrame(frame);
+		}
+		else if (m_FramesInFlight == 2 && previousFrame.stage == FrameStage::Rasterized)
+		{
+			PresentFrame(previousFrame);
 		}
-		//@END
-		//Update SDL Surface
-		SDL_UnlockSurface(m_pBackBuffer);
-		SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-		SDL_UpdateWindowSurface(m_pWindow);
 
+		m_FrameAllocationCount = GetAllocationCount() - allocationCount;
 	}
 
-	void Software::VertexTransformationFunction(const std::vector<Mesh*>& mesh, const Camera& camera) const
+	void Software::RecordGeometry(Frame& frame, const Camera& camera)
 	{
-		for (auto& m : mesh)
+		// The slot's previous frame is presented, nothing points into its arena anymore.
+		frame.arena.Reset();
+
+		frame.renderWidth = m_Width;
+		frame.renderHeight = m_Height;
+		if (m_ResolutionScale < 1.f)
 		{
-			const auto worldViewProjectionMatrix{ m->m_WorldMatrix * camera.viewMatrix * camera.projectionMatrix };
+			// A window smaller than a step is rendered at its full size.
+			frame.renderWidth = std::clamp(static_cast<int>(static_cast<float>(m_Width) * m_ResolutionScale) / ResolutionStep * ResolutionStep, std::min(ResolutionStep, m_Width), m_Width);
+			frame.renderHeight = std::clamp(static_cast<int>(static_cast<float>(m_Height) * m_ResolutionScale) / ResolutionStep * ResolutionStep, std::min(ResolutionStep, m_Height), m_Height);
+		}
 
-			const size_t verticesSize = m->m_VerticesIn.size();
+		// Snapshot and bin every light of the LightManager once for the whole frame.
+		frame.lights.SetViewport(frame.renderWidth, frame.renderHeight);
+		frame.lights.SetCountingPixels(m_StatsEnabled);
+		frame.lights.Build(LightManager::GetInstance().GetLights(), camera);
 
-			//std::mutex mtx;
-			concurrency::parallel_for(static_cast<size_t>(0), verticesSize, [=](const size_t i)
-			{
-				// Projection.
-				Vector4 projectedVertex{ worldViewProjectionMatrix.TransformPoint(m->m_VerticesIn.at(i).position.x, m->m_VerticesIn.at(i).position.y, m->m_VerticesIn.at(i).position.z, 1) };
+		// The shadow map renders while the batches are set up.
+		JobSystem& jobSystem{ JobSystem::GetInstance() };
+		const JobSystem::JobHandle shadowJob{ jobSystem.Schedule([this, &frame] { UpdateShadowMap(frame); }) };
 
-				// World space normal calculation.
-				const Vector3 worldSpaceNormal{ m->m_WorldMatrix.TransformVector(m->m_VerticesIn.at(i).normal).Normalized() };
+		// Transparent batches are blended over the finished opaque pixels, the debug views show only the opaque depth and triangles.
+		const bool drawsTransparent{ m_ToggleTransparentMeshes && !m_DepthBufferVisualized && !m_ToggleBoundingBox };
 
-				// Tangent calculation.
-				const Vector3 tangent{ m->m_WorldMatrix.TransformVector(m->m_VerticesIn.at(i).tangent).Normalized() };
+		// Every batch runs the vertex stage of its effect and is set up and binned as one triangle list.
+		for (DrawBatch& batch : m_Batches)
+		{
+			BatchGeometry& geometry{ batch.frames[frame.slot] };
+			geometry.triangles = {};
+			geometry.bins.Resize(frame.renderWidth, frame.renderHeight);
+			if (batch.pEffect->IsTransparent() && !drawsTransparent)
+			{
+				geometry.bins.Clear();
+				continue;
+			}
 
-				// View Direction Calculation.
-				const Vector3 viewDirection{ camera.origin - m->m_WorldMatrix.TransformPoint(m->m_VerticesIn.at(i).position) };
+			size_t triangleCount{};
+			for (const Mesh* pMesh : batch.pMeshes)
+			{
+				triangleCount += GetTriangleCount(*pMesh);
+			}
+			geometry.triangles = frame.arena.Allocate<RasterTriangle>(triangleCount);
 
-				// Perspective Divide.
-				projectedVertex.x /= projectedVertex.w;
-				projectedVertex.y /= projectedVertex.w;
-				projectedVertex.z /= projectedVertex.w;
+			// A batch sets up all of its meshes into one list.
+			size_t firstTriangle{};
+			for (Mesh* pMesh : batch.pMeshes)
+			{
+				batch.pEffect->TransformVertices(*pMesh, camera);
+				SetupTriangles(*pMesh, pMesh->m_VerticesOut, geometry.triangles.subspan(firstTriangle, GetTriangleCount(*pMesh)), frame.renderWidth, frame.renderHeight);
+				firstTriangle += GetTriangleCount(*pMesh);
+			}
+			BinTriangles(geometry.triangles, geometry.bins);
+		}
 
-				const Vertex_Out temp{ projectedVertex, m->m_VerticesIn.at(i).color, m->m_VerticesIn.at(i).uv, worldSpaceNormal, tangent, viewDirection };
+		jobSystem.Wait(shadowJob);
+
+		// The padded window width stays the row pitch of the depth and color buffers at every render size.
+		frame.state = RasterState{
+			&m_ColorBuffer,
+			m_pDepthBuffer,
+			m_DepthFormat,
+			m_ColorBuffer.GetStride(),
+			ShadingRate::Rate1x1,
+			m_CurrentCullingMode,
+			m_DepthBufferVisualized,
+			m_ToggleBoundingBox,
+			camera.origin,
+			camera.nearPlane,
+			&frame.lights,
+			&frame.shadowMap,
+			frame.shadowLightIndex };
+
+		frame.stage = FrameStage::Recorded;
+	}
 
-				//std::unique_lock<std::mutex> lock(mtx);
-				//m->m_VerticesOut.emplace_back(temp);
-				//lock.unlock();
+	void Software::BeginRaster(Frame& frame)
+	{
+		frame.pTarget = GetRasterTarget(frame);
+		if (frame.pTarget == frame.pBackBuffer)
+		{
+			// The back buffer may still be on its way to the window from MaxFramesInFlight frames ago.
+			m_pPresenter->WaitUntilReleased(frame.pBackBuffer);
+		}
+		else
+		{
+			// The window surface is the only buffer SDL hands out, the last present has to be on screen before it is written again.
+			// SDL_UpdateWindowSurface copies it out, so the window never shows a frame being resolved.
+			m_pPresenter->Flush();
+			++m_ZeroCopyFrameCount;
+		}
 
-				m->m_VerticesOut.at(i) = temp;
+		for (DrawBatch& batch : m_Batches)
+		{
+			batch.pEffect->BeginFrame(frame.state);
+		}
 
-			});
+		// Before the clear, the luminance metric reads the previous frame.
+		if (!m_Batches.empty())
+		{
+			UpdateShadingRates(frame);
+			ScheduleTiles(frame);
 		}
 	}
 
-	void Software::PixelRenderLoop(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const
+	SDL_Surface* Software::GetRasterTarget(const Frame& frame) const
 	{
-		// Bounding Box.
-		Vector3 min{}, max{};
-		min = Vector3::Min(v0.position, Vector3::Min(v1.position, v2.position));
-		max = Vector3::Max(v0.position, Vector3::Max(v1.position, v2.position));
+		SDL_Surface* pWindowSurface{ m_pPresenter->GetWindowSurface() };
+		const bool isSameLayout{ pWindowSurface->format->format == m_SurfaceFormat && pWindowSurface->w == m_Width && pWindowSurface->h == m_Height };
 
-		Vector3 margin{ 1.f, 1.f, 1.f };
-		min -= margin;
-		max += margin;
+		// With three frames in flight the frame before is still to be presented, its copy into the window surface would land in the middle of this raster.
+		const bool isOtherFramePending{ std::any_of(m_pFrames.begin(), m_pFrames.end(), [&frame](const Frame* pOther)
+		{
+			return pOther != &frame && pOther->stage == FrameStage::Rasterized;
+		}) };
 
-		min = Vector3::Max({ 0, 0, 0 }, Vector3::Min({ static_cast<float>(m_Width - 1), static_cast<float>(m_Height - 1), 0.f }, min));
-		max = Vector3::Max({ 0, 0, 0 }, Vector3::Min({ static_cast<float>(m_Width - 1), static_cast<float>(m_Height - 1), 0.f }, max));
+		return m_ZeroCopyPresent && isSameLayout && !isOtherFramePending ? pWindowSurface : frame.pBackBuffer;
+	}
 
-		for (int px{ static_cast<int>(min.x) }; px < static_cast<int>(max.x); ++px)
+	void Software::ScheduleTiles(Frame& frame)
+	{
+		const TileBinner& screenTiles{ m_Batches.front().frames[frame.slot].bins };
+		const int tileCount{ screenTiles.GetTileCount() };
+
+		// Bin estimate: the bounding box pixels every triangle covers in the tile, a setup cost per triangle and the resolve.
+		const std::span<float> estimates{ frame.arena.Allocate<float>(tileCount) };
+		m_TileHasTriangles.assign(tileCount, 0);
+		for (int tileIndex = 0; tileIndex < tileCount; ++tileIndex)
 		{
-			for (int py{ static_cast<int>(min.y) }; py < static_cast<int>(max.y); ++py)
+			const Tile& tile{ screenTiles.GetTile(tileIndex) };
+			float estimate{ static_cast<float>((tile.maxX - tile.minX) * (tile.maxY - tile.minY)) * ResolveCost };
+			for (const DrawBatch& batch : m_Batches)
 			{
-				if (m_ToggleBoundingBox)
+				const BatchGeometry& geometry{ batch.frames[frame.slot] };
+				m_TileHasTriangles[tileIndex] |= geometry.bins.GetTriangles(tileIndex).empty() ? 0 : 1;
+				for (const uint32_t triangleIndex : geometry.bins.GetTriangles(tileIndex))
 				{
-					m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(255),
-						static_cast<uint8_t>(255),
-						static_cast<uint8_t>(255));
+					const RasterTriangle& triangle{ geometry.triangles[triangleIndex] };
+					const int width{ std::min(triangle.maxX, tile.maxX) - std::max(triangle.minX, tile.minX) };
+					const int height{ std::min(triangle.maxY, tile.maxY) - std::max(triangle.minY, tile.minY) };
+					estimate += TriangleSetupCost + static_cast<float>(std::max(width, 0) * std::max(height, 0));
 				}
-				else
-				{
-					Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
+			}
+			estimates[tileIndex] = estimate;
+		}
+
+		// The last raster calibrates the estimate per tile, it knows what the tile's shading costs.
+		// Tiles it has no measurement for use the average.
+		if (screenTiles.GetWidth() != m_TileTimingWidth || screenTiles.GetHeight() != m_TileTimingHeight)
+		{
+			m_TileEstimates.clear();
+			m_TileNanoseconds.clear();
+			m_TileTimingWidth = screenTiles.GetWidth();
+			m_TileTimingHeight = screenTiles.GetHeight();
+		}
+		const bool isCalibrated{ static_cast<int>(m_TileNanoseconds.size()) == tileCount };
+		float averageRate{ 1.f };
+		if (isCalibrated)
+		{
+			float totalEstimate{}, totalNanoseconds{};
+			for (int tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+			{
+				totalEstimate += m_TileEstimates[tileIndex];
+				totalNanoseconds += m_TileNanoseconds[tileIndex];
+			}
+			averageRate = totalEstimate > 0.f && totalNanoseconds > 0.f ? totalNanoseconds / totalEstimate : 1.f;
+		}
+
+		const std::span<float> costs{ frame.arena.Allocate<float>(tileCount) };
+		float totalCost{};
+		for (int tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+		{
+			const bool hasMeasurement{ isCalibrated && m_TileEstimates[tileIndex] > 0.f && m_TileNanoseconds[tileIndex] > 0.f };
+			const float rate{ hasMeasurement ? m_TileNanoseconds[tileIndex] / m_TileEstimates[tileIndex] : averageRate };
+			costs[tileIndex] = estimates[tileIndex] * rate;
+			totalCost += costs[tileIndex];
+		}
+		m_TileEstimates.assign(estimates.begin(), estimates.end());
 
-					//edges
-					const Vector2 v0v1{ v1.position.GetXY() - v0.position.GetXY() };
-					const Vector2 v1v2{ v2.position.GetXY() - v1.position.GetXY() };
-					const Vector2 v2v0{ v0.position.GetXY() - v2.position.GetXY() };
+		// A tile worth more than half of a thread's share is split into 2 or 4 strips.
+		// Strips are a multiple of 4 rows, so the 4x4 coarse pixels and the quads stay inside them.
+		const int threadCount{ JobSystem::GetInstance().GetWorkerCount() + 1 };
+		const float splitCost{ totalCost / static_cast<float>(threadCount * 2) };
 
-					const Vector2 v0v2{ v2.position.GetXY() - v0.position.GetXY() };
+		m_TileWork.clear();
+		m_SplitTileCount = 0;
+		for (int tileIndex = 0; tileIndex < tileCount; ++tileIndex)
+		{
+			const Tile& tile{ screenTiles.GetTile(tileIndex) };
+			int stripCount{ 1 };
+			if (threadCount > 1 && costs[tileIndex] > splitCost)
+			{
+				stripCount = costs[tileIndex] > 2.f * splitCost ? 4 : 2;
+				++m_SplitTileCount;
+			}
 
-					// Vector from vertex to pixel.
-					Vector2 vertexToPixel1{ pixel - v0.position.GetXY() };
-					Vector2 vertexToPixel2{ pixel - v1.position.GetXY() };
-					Vector2 vertexToPixel3{ pixel - v2.position.GetXY() };
+			const int stripHeight{ ((TileBinner::TileSize / stripCount) + 3) & ~3 };
+			for (int minY = tile.minY; minY < tile.maxY; minY += stripHeight)
+			{
+				const Tile strip{ tile.minX, minY, tile.maxX, std::min(minY + stripHeight, tile.maxY) };
+				m_TileWork.push_back(TileWork{ tileIndex, strip, costs[tileIndex] * static_cast<float>(strip.maxY - strip.minY) / static_cast<float>(tile.maxY - tile.minY) });
+			}
+		}
+
+		// Not stable_sort, which allocates its merge buffer. Ties go by tile and strip, so the order stays the same from frame to frame.
+		std::sort(m_TileWork.begin(), m_TileWork.end(), [](const TileWork& a, const TileWork& b)
+		{
+			if (a.cost != b.cost)
+			{
+				return a.cost > b.cost;
+			}
+			return a.tileIndex != b.tileIndex ? a.tileIndex < b.tileIndex : a.rect.minY < b.rect.minY;
+		});
+	}
+
+	void Software::RasterizeFrame(Frame& frame)
+	{
+		//@START
+		//Lock BackBuffer
+		SDL_LockSurface(frame.pTarget);
+		uint32_t* pBackBufferPixels{ static_cast<uint32_t*>(frame.pTarget->pixels) };
+
+		// Nothing is cleared up front, every tile clears itself in its job.
+		UINT8 color;
+		m_UniformBg ? color = 25 : color = 100;
+		const ColorRGB clearColor{ ColorRGB{ 1, 1, 1 } * (color / 255.f) };
 
-					//Cross of vertex to pixel and vertex
-					float signedArea1{ Vector2::Cross(v0v1, vertexToPixel1) };
-					float signedArea2{ Vector2::Cross(v1v2, vertexToPixel2) };
-					float signedArea3{ Vector2::Cross(v2v0, vertexToPixel3) };
+		//RENDER LOGIC
+		// A tile belongs to one thread, so its depth tests and blends never race.
+		// Every batch bins onto the same screen tiles.
+		const int pixelsPerRow{ frame.pTarget->pitch / static_cast<int>(sizeof(uint32_t)) };
+		// Below the window size the tiles cannot resolve themselves, the whole frame is scaled up once every tile is done.
+		const bool isUpscaled{ frame.renderWidth != m_Width || frame.renderHeight != m_Height };
+		if (m_Batches.empty())
+		{
+			m_ColorBuffer.ResolveClear(Tile{ 0, 0, m_Width, m_Height }, clearColor, pBackBufferPixels, pixelsPerRow, m_PixelFormat);
+		}
+		else
+		{
+			// Work items are disjoint pixel rectangles, so their depth tests, blends and resolves never race.
+			m_TileWorkNanoseconds.assign(m_TileWork.size(), 0);
+			JobSystem::GetInstance().ParallelForOrdered(m_TileWork.size(), [&](const size_t workIndex)
+			{
+				const auto start{ std::chrono::steady_clock::now() };
+				const int tileIndex{ m_TileWork[workIndex].tileIndex };
+				const Tile& tile{ m_TileWork[workIndex].rect };
+				if (!m_TileHasTriangles[tileIndex])
+				{
+					// The upscale filter reads the float colors, otherwise the clear color goes straight to the back buffer.
+					if (isUpscaled)
+					{
+						m_ColorBuffer.Clear(tile, clearColor);
+					}
+					else
+					{
+						m_ColorBuffer.ResolveClear(tile, clearColor, pBackBufferPixels, pixelsPerRow, m_PixelFormat);
+					}
+					m_TileWorkNanoseconds[workIndex] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+					return;
+				}
 
-					// Culling Check.
-					bool isBackCulling{ signedArea1 > 0 && signedArea2 > 0 && signedArea3 > 0 };
-					bool isFrontCulling{ signedArea1 < 0 && signedArea2 < 0 && signedArea3 < 0 };
+				// Cleared by the thread that draws the tile right after, so the clear warms its cache instead of costing a pass of its own.
+				ClearTile(frame.state, tile, clearColor);
 
-					if ((m_CurrentCullingMode == Culling::Back && isBackCulling) || (m_CurrentCullingMode == Culling::Front
-						&& isFrontCulling) || (m_CurrentCullingMode == Culling::None && (isFrontCulling || isBackCulling)))
+				RasterState tileState{ frame.state };
+				tileState.shadingRate = m_TileShadingRates[tileIndex];
+				for (const DrawBatch& batch : m_Batches)
+				{
+					const BatchGeometry& geometry{ batch.frames[frame.slot] };
+					if (!batch.pEffect->IsTransparent() && !geometry.bins.GetTriangles(tileIndex).empty())
 					{
-						// Pixel inside triangle.
-						float areaTotalParallelogram{ Vector2::Cross(v0v1, v0v2) };
-
-						float W0{ signedArea2 / areaTotalParallelogram };
-						float W1{ signedArea3 / areaTotalParallelogram };
-						float W2{ signedArea1 / areaTotalParallelogram };
-
-						float zBufferValue{ ZBufferValue(v0, v1, v2, W0, W1, W2) };
-
-						float depth = m_pDepthBufferPixels[py * m_Width + px];
-						if (zBufferValue < depth)
-						{
-							m_pDepthBufferPixels[py * m_Width + px] = zBufferValue;
-							float wInterpolated{ WInterpolated(v0, v1, v2, W0, W1, W2) };
-							Vector2 uv{ UVInterpolated(v0, v1, v2, W0, W1, W2, wInterpolated) };
-							Vector3 normal{ NormalInterpolated(v0, v1, v2, W0, W1, W2, wInterpolated).Normalized() };
-							Vector3 tangent{ TangentInterpolated(v0, v1, v2, W0, W1, W2, wInterpolated).Normalized() };
-							Vector3 viewDirection{ ViewDirInterpolated(v0, v1, v2, W0, W1, W2, wInterpolated).Normalized() };
-
-							ColorRGB finalColor{};
-
-							if (!m_DepthBufferVisualized)
-							{
-								const Vector4 pixelPos{ static_cast<float>(px), static_cast<float>(py), zBufferValue, wInterpolated };
-								Vertex_Out pixelVertex{ pixelPos, finalColor, uv, normal, tangent, viewDirection };
-								finalColor = PixelShading(pixelVertex);
-							}
-							else
-							{
-								finalColor = ColorRGB{ 1, 1, 1 } * Remap(zBufferValue, 0.985f, 1.f, 0.f, 1.f);
-							}
-
-							//Update Color in Buffer
-							finalColor.MaxToOne();
-
-							m_pBackBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-								static_cast<uint8_t>(finalColor.r * 255),
-								static_cast<uint8_t>(finalColor.g * 255),
-								static_cast<uint8_t>(finalColor.b * 255));
-						}
+						batch.pEffect->DrawTile(tileState, geometry.triangles, geometry.bins.GetTriangles(tileIndex), tile);
 					}
 				}
+
+				// The tile's opaque depth is final here.
+				RenderTransparentTile(frame, tileIndex, tile, frame.state);
+
+				if (!isUpscaled)
+				{
+					m_ColorBuffer.Resolve(tile, pBackBufferPixels, pixelsPerRow, m_PixelFormat);
+				}
+
+				m_TileWorkNanoseconds[workIndex] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			});
+
+			// Strips add up to their tile for the next frame's estimate.
+			m_TileNanoseconds.assign(m_Batches.front().frames[frame.slot].bins.GetTileCount(), 0.f);
+			int64_t totalNanoseconds{}, heaviestNanoseconds{};
+			for (size_t workIndex = 0; workIndex < m_TileWork.size(); ++workIndex)
+			{
+				m_TileNanoseconds[m_TileWork[workIndex].tileIndex] += static_cast<float>(m_TileWorkNanoseconds[workIndex]);
+				totalNanoseconds += m_TileWorkNanoseconds[workIndex];
+				heaviestNanoseconds = std::max(heaviestNanoseconds, m_TileWorkNanoseconds[workIndex]);
+			}
+			m_HeaviestWorkShare = totalNanoseconds > 0 ? static_cast<float>(heaviestNanoseconds) / static_cast<float>(totalNanoseconds) : 0.f;
+
+			if (isUpscaled)
+			{
+				const int rowBlockCount{ (m_Height + UpscaleRowsPerJob - 1) / UpscaleRowsPerJob };
+				JobSystem::GetInstance().ParallelFor(0, rowBlockCount, 1, [&](const int rowBlock)
+				{
+					const int minY{ rowBlock * UpscaleRowsPerJob };
+					m_ColorBuffer.ResolveUpscaled(frame.renderWidth, frame.renderHeight, m_Width, m_Height, minY, std::min(minY + UpscaleRowsPerJob, m_Height),
+						pBackBufferPixels, pixelsPerRow, m_PixelFormat);
+				});
 			}
 		}
+		//@END
+		SDL_UnlockSurface(frame.pTarget);
+
+		frame.stage = FrameStage::Rasterized;
+		m_pStatsFrame = &frame;
 	}
 
-	float Software::ZBufferValue(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2) const
+	void Software::PresentFrame(Frame& frame)
 	{
-		const float denominator = (1.0f / v0.position.z) * w0 + (1.0f / v1.position.z) * w1 + (1.0f / v2.position.z) * w2;
-		return (1 / denominator);
+		// A frame left over from a deeper pipeline is dropped once a newer one is on screen.
+		if (frame.number > m_PresentedFrameNumber)
+		{
+			//Update SDL Surface, on the present thread
+			m_pPresenter->Submit(frame.pTarget);
+			m_PresentedFrameNumber = frame.number;
+		}
+
+		frame.stage = FrameStage::Free;
 	}
 
-	float Software::WInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2) const
+	size_t Software::GetTriangleCount(const Mesh& mesh)
 	{
-		const float denominator = (1.0f / v0.position.w) * w0 + (1.0f / v1.position.w) * w1 + (1.0f / v2.position.w) * w2;
-		return (1 / denominator);
+		return mesh.m_PrimitiveTopology == Mesh::PrimitiveTopology::TriangleList ? mesh.m_Indices.size() / 3 : mesh.m_Indices.size() - 2;
 	}
 
-	Vector2 Software::UVInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated) const
+	void Software::SetupTriangles(const Mesh& mesh, std::span<const Vertex_Out> vertices, std::span<RasterTriangle> triangles, int width, int height) const
 	{
-		return ((v0.uv / v0.position.w) * w0 + (v1.uv / v1.position.w) * w1 + (v2.uv / v2.position.w) * w2) * wInterpolated;
+		const bool isTriangleList{ mesh.m_PrimitiveTopology == Mesh::PrimitiveTopology::TriangleList };
+		const size_t triangleCount{ GetTriangleCount(mesh) };
+		assert(triangles.size() == triangleCount && "One RasterTriangle per triangle of the mesh.");
+
+		JobSystem::GetInstance().ParallelFor(static_cast<size_t>(0), triangleCount, SoftwareRaster::TrianglesPerJob, [&](const size_t triangleIndex)
+		{
+			uint32_t index1{}, index2{}, index3{};
+			if (isTriangleList)
+			{
+				index1 = mesh.m_Indices[triangleIndex * 3];
+				index2 = mesh.m_Indices[triangleIndex * 3 + 1];
+				index3 = mesh.m_Indices[triangleIndex * 3 + 2];
+			}
+			else
+			{
+				index1 = mesh.m_Indices[triangleIndex];
+				index2 = mesh.m_Indices[triangleIndex + 1];
+				index3 = mesh.m_Indices[triangleIndex + 2];
+
+				if (index3 % 2 == 1)
+				{
+					index2 = mesh.m_Indices[triangleIndex + 2];
+					index3 = mesh.m_Indices[triangleIndex + 1];
+				}
+			}
+
+			RasterTriangle& triangle{ triangles[triangleIndex] };
+			triangle.v0 = vertices[index1];
+			triangle.v1 = vertices[index2];
+			triangle.v2 = vertices[index3];
+
+			// Clipping.
+			triangle.isVisible = false;
+			for (const Vertex_Out* pVertex : { &triangle.v0, &triangle.v1, &triangle.v2 })
+			{
+				if (pVertex->position.x < -1 || pVertex->position.x > 1 ||
+					pVertex->position.y < -1 || pVertex->position.y > 1)
+				{
+					return;
+				}
+			}
+
+			// NDC to raster.
+			for (Vertex_Out* pVertex : { &triangle.v0, &triangle.v1, &triangle.v2 })
+			{
+				pVertex->position.x = ((pVertex->position.x + 1) / 2) * static_cast<float>(width);
+				pVertex->position.y = ((1 - pVertex->position.y) / 2) * static_cast<float>(height);
+			}
+
+			// A triangle without area covers no pixel, and its barycentric weights would divide by zero.
+			const Vector2 edge1{ triangle.v1.position.GetXY() - triangle.v0.position.GetXY() };
+			const Vector2 edge2{ triangle.v2.position.GetXY() - triangle.v0.position.GetXY() };
+			if (Vector2::Cross(edge1, edge2) == 0.f)
+			{
+				return;
+			}
+
+			// Bounding Box.
+			Vector3 min{}, max{};
+			min = Vector3::Min(triangle.v0.position, Vector3::Min(triangle.v1.position, triangle.v2.position));
+			max = Vector3::Max(triangle.v0.position, Vector3::Max(triangle.v1.position, triangle.v2.position));
+
+			Vector3 margin{ 1.f, 1.f, 1.f };
+			min -= margin;
+			max += margin;
+
+			min = Vector3::Max({ 0, 0, 0 }, Vector3::Min({ static_cast<float>(width - 1), static_cast<float>(height - 1), 0.f }, min));
+			max = Vector3::Max({ 0, 0, 0 }, Vector3::Min({ static_cast<float>(width - 1), static_cast<float>(height - 1), 0.f }, max));
+
+			triangle.minX = static_cast<int>(min.x);
+			triangle.minY = static_cast<int>(min.y);
+			triangle.maxX = static_cast<int>(max.x);
+			triangle.maxY = static_cast<int>(max.y);
+			triangle.sortDepth = (triangle.v0.position.w + triangle.v1.position.w + triangle.v2.position.w) / 3.f;
+			triangle.isVisible = true;
+		});
 	}
 
-	Vector3 Software::NormalInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated) const
+	void Software::BinTriangles(std::span<const RasterTriangle> triangles, TileBinner& bins) const
 	{
-		return ((v0.normal / v0.position.w) * w0 + (v1.normal / v1.position.w) * w1 + (v2.normal / v2.position.w) * w2) * wInterpolated;
+		// Binning in index order keeps the draw order of every tile the mesh order.
+		bins.Clear();
+		for (uint32_t triangleIndex = 0; triangleIndex < static_cast<uint32_t>(triangles.size()); ++triangleIndex)
+		{
+			const RasterTriangle& triangle{ triangles[triangleIndex] };
+			if (triangle.isVisible)
+			{
+				bins.Bin(triangleIndex, triangle.minX, triangle.minY, triangle.maxX, triangle.maxY);
+			}
+		}
 	}
 
-	Vector3 Software::TangentInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated) const
+	void Software::UpdateShadowMap(Frame& frame)
 	{
-		return ((v0.tangent / v0.position.w) * w0 + (v1.tangent / v1.position.w) * w1 + (v2.tangent / v2.position.w) * w2) * wInterpolated;
+		frame.shadowLightIndex = NoShadowLight;
+		if (!m_ToggleShadows)
+		{
+			return;
+		}
+
+		const LightBuffer& lights{ frame.lights.GetLights() };
+		for (uint32_t lightIndex = 0; lightIndex < static_cast<uint32_t>(lights.GetCount()); ++lightIndex)
+		{
+			if (lights.types[lightIndex] == LightType::Directional)
+			{
+				frame.shadowLightIndex = lightIndex;
+				break;
+			}
+		}
+
+		if (frame.shadowLightIndex == NoShadowLight || !m_pShadowCaster)
+		{
+			return;
+		}
+
+		const Vector3 lightDirection{ lights.directionX[frame.shadowLightIndex], lights.directionY[frame.shadowLightIndex], lights.directionZ[frame.shadowLightIndex] };
+		if (frame.shadowMap.Update(lightDirection, m_pShadowCaster->m_WorldMatrix, m_pShadowCaster->GetWorldBoundingCenter(), m_pShadowCaster->GetBoundingRadius()))
+		{
+			RenderShadowMap(frame);
+		}
 	}
 
-	Vector3 Software::ViewDirInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated) const
+	void Software::RenderShadowMap(Frame& frame)
 	{
-		return ((v0.viewDirection / v0.position.w) * w0 + (v1.viewDirection / v1.position.w) * w1 + (v2.viewDirection / v2.position.w) * w2) * wInterpolated;
+		const Mesh& caster{ *m_pShadowCaster };
+		const Matrix worldViewProjectionMatrix{ caster.m_WorldMatrix * frame.shadowMap.GetLightViewProjection() };
+
+		// Only the positions, the depth pass interpolates nothing else.
+		const std::span<Vertex_Out> shadowVertices{ frame.arena.Allocate<Vertex_Out>(caster.m_VerticesIn.size()) };
+		JobSystem::GetInstance().ParallelFor(static_cast<size_t>(0), caster.m_VerticesIn.size(), SoftwareRaster::VerticesPerJob, [&](const size_t i)
+		{
+			const Vector3& position{ caster.m_VerticesIn[i].position };
+			Vector4 projectedVertex{ worldViewProjectionMatrix.TransformPoint(position.x, position.y, position.z, 1) };
+
+			projectedVertex.x /= projectedVertex.w;
+			projectedVertex.y /= projectedVertex.w;
+			projectedVertex.z /= projectedVertex.w;
+
+			shadowVertices[i].position = projectedVertex;
+		});
+
+		TileBinner& bins{ frame.shadowMap.GetBins() };
+		const std::span<RasterTriangle> shadowTriangles{ frame.arena.Allocate<RasterTriangle>(GetTriangleCount(caster)) };
+		SetupTriangles(caster, shadowVertices, shadowTriangles, ShadowMap::Resolution, ShadowMap::Resolution);
+		BinTriangles(shadowTriangles, bins);
+
+		// The shadow map is a float depth buffer of its own, sampled as is.
+		RasterState shadowState{};
+		shadowState.pDepthBuffer = frame.shadowMap.GetDepth();
+		shadowState.depthFormat = DepthFormat::Float32;
+		shadowState.stride = ShadowMap::Resolution;
+		SoftwareRaster::ClearDepth(shadowState, Tile{ 0, 0, ShadowMap::Resolution, ShadowMap::Resolution });
+
+		JobSystem::GetInstance().ParallelFor(0, bins.GetTileCount(), 1, [&](const int tileIndex)
+		{
+			const Tile& tile{ bins.GetTile(tileIndex) };
+			for (const uint32_t triangle : bins.GetTriangles(tileIndex))
+			{
+				// Both faces cast, so thin or open parts of the caster do not leak light.
+				SoftwareRaster::RasterizeDepthOnly<Culling::None, DepthFormat::Float32>(shadowState, shadowTriangles[triangle], tile);
+			}
+		});
 	}
 
-	float Software::Remap(float value, float oldRangeL, float oldRangeN, float newRangeL, float newRangeN) const
+	void Software::ClearTile(const RasterState& state, const Tile& tile, const ColorRGB& clearColor)
 	{
-		const float newVal{ std::clamp(value, oldRangeL, oldRangeN) };
-		return newRangeL + (newVal - oldRangeL) * (newRangeN - newRangeL) / (newRangeN - oldRangeL);
+		SoftwareRaster::ClearDepth(state, tile);
+		m_ColorBuffer.Clear(tile, clearColor);
 	}
 
-	ColorRGB Software::PixelShading(const Vertex_Out& v) const
+	void Software::RenderTransparentTile(Frame& frame, int tileIndex, const Tile& tile, const RasterState& state) const
 	{
-		const Vector3 lightDirection{ m_pDirectionalLight->GetDirection() };
-		const float lightIntensity{ m_pDirectionalLight->GetlightIntensity() };
-		constexpr ColorRGB ambient{ 0.025f, 0.025f, 0.025f };
+		bool hasTransparentTriangles{ false };
+		for (const DrawBatch& batch : m_Batches)
+		{
+			hasTransparentTriangles |= batch.pEffect->IsTransparent() && !batch.frames[frame.slot].bins.GetTriangles(tileIndex).empty();
+		}
 
-		Vector3 tangentSpaceVector = v.normal;
+		if (!hasTransparentTriangles)
+		{
+			return;
+		}
 
-		if (m_ToggleNormalMap)
+		// Back to front within a batch, so every triangle blends over what is behind it. Batches blend in the order they were added.
+		for (const DrawBatch& batch : m_Batches)
 		{
-			//// Calculate Binormal.
-			const Vector3 binormal{ Vector3::Cross(v.normal, v.tangent).Normalized() };
+			const BatchGeometry& geometry{ batch.frames[frame.slot] };
+			if (!batch.pEffect->IsTransparent() || geometry.bins.GetTriangles(tileIndex).empty())
+			{
+				continue;
+			}
 
-			//// Calculate Tangent space Matrix.
-			const Matrix tangentSpaceMatrix{ v.tangent, binormal, v.normal, Vector3::Zero };
+			const std::vector<uint32_t>& tileTriangles{ geometry.bins.GetTriangles(tileIndex) };
+			const std::span<uint32_t> sortedTriangles{ frame.arena.Allocate<uint32_t>(tileTriangles.size()) };
+			std::copy(tileTriangles.begin(), tileTriangles.end(), sortedTriangles.begin());
+			std::sort(sortedTriangles.begin(), sortedTriangles.end(), [&geometry](uint32_t a, uint32_t b)
+			{
+				return geometry.triangles[a].sortDepth > geometry.triangles[b].sortDepth;
+			});
 
-			//// Calculate Normal according to the Normal Map.
-			const ColorRGB normalMapCol{ (2 * m_pNormalVehicle->Sample(v.uv)) - colors::White };
-			Vector3 normalMapVector{ normalMapCol.r, normalMapCol.g, normalMapCol.b };
-			normalMapVector /= 255.f;
-			tangentSpaceVector = tangentSpaceMatrix.TransformVector(normalMapVector).Normalized();
+			batch.pEffect->DrawTile(state, geometry.triangles, sortedTriangles, tile);
 		}
+	}
 
-		const float lambertCosineLaw{ GetLambertCosine(tangentSpaceVector, lightDirection) };
-
-		if (lambertCosineLaw < 0.f)
+	void Software::UpdateShadingRates(const Frame& frame)
+	{
+		const TileBinner& screenTiles{ m_Batches.front().frames[frame.slot].bins };
+		m_TileShadingRates.assign(screenTiles.GetTileCount(), ShadingRate::Rate1x1);
+		if (m_ShadingRateMode == ShadingRateMode::Coarse)
 		{
-			return { 0,0,0 };
+			std::fill(m_TileShadingRates.begin(), m_TileShadingRates.end(), ShadingRate::Rate2x2);
 		}
+		else if (m_ShadingRateMode == ShadingRateMode::Distance)
+		{
+			// The nearest opaque triangle of the tile decides, so a tile is only coarse when everything in it is far away.
+			for (int tileIndex = 0; tileIndex < screenTiles.GetTileCount(); ++tileIndex)
+			{
+				float nearestDepth{ FLT_MAX };
+				for (const DrawBatch& batch : m_Batches)
+				{
+					if (batch.pEffect->IsTransparent())
+					{
+						continue;
+					}
 
-		constexpr float specularShininess{ 25.f };
-		const float specularExp{ specularShininess * m_pGlossVehicle->Sample(v.uv).r };
-		const ColorRGB specular{ BRDF::Phong(m_pSpecularVehicle->Sample(v.uv), 1.f, specularExp, lightDirection, v.viewDirection, tangentSpaceVector) };
-		const ColorRGB lambert{ BRDF::Lambert(1.0f, m_pDiffuseVehicle->Sample(v.uv)) };
+					const BatchGeometry& geometry{ batch.frames[frame.slot] };
+					for (const uint32_t triangle : geometry.bins.GetTriangles(tileIndex))
+					{
+						nearestDepth = std::min(nearestDepth, geometry.triangles[triangle].sortDepth);
+					}
+				}
 
-		switch (m_ShadingMode)
+				int rate{};
+				while (rate < static_cast<int>(DistanceRateThresholds.size()) && nearestDepth >= DistanceRateThresholds[rate])
+				{
+					++rate;
+				}
+				m_TileShadingRates[tileIndex] = static_cast<ShadingRate>(rate);
+			}
+		}
+		else if (m_ShadingRateMode == ShadingRateMode::Luminance)
 		{
-		case ShadingModes::Combined:
-			return ((lambert * lightIntensity + specular) * lambertCosineLaw) + ambient;
-			break;
-		case ShadingModes::ObservedArea:
-			return ColorRGB{ 1, 1, 1 } * lambertCosineLaw;
-			break;
-		case ShadingModes::Diffuse:
-			return (lambert * lambertCosineLaw * lightIntensity);
-			break;
-		case ShadingModes::Specular:
-			return specular;
-			break;
-		default:
-			return ((lambert * lightIntensity + specular) * lambertCosineLaw) + ambient;
+			// Flat tiles of the previous frame lose little detail at a coarse rate.
+			// Tiles it drew nothing in were never cleared, the color buffer holds an older frame there, but they were the flat clear color.
+			const bool hasClearState{ static_cast<int>(m_TileHasTriangles.size()) == screenTiles.GetTileCount() };
+			JobSystem::GetInstance().ParallelFor(0, screenTiles.GetTileCount(), 1, [&](const int tileIndex)
+			{
+				const bool wasDrawn{ !hasClearState || m_TileHasTriangles[tileIndex] };
+				const float gradient{ wasDrawn ? m_ColorBuffer.GetLuminanceGradient(screenTiles.GetTile(tileIndex)) : 0.f };
+
+				int rate{};
+				while (rate < static_cast<int>(LuminanceRateThresholds.size()) && gradient < LuminanceRateThresholds[rate])
+				{
+					++rate;
+				}
+				m_TileShadingRates[tileIndex] = static_cast<ShadingRate>(rate);
+			});
 		}
-	}
 
-	float Software::GetLambertCosine(const Vector3& normal, const Vector3& lightDirection) const
-	{
-		const float lambertCosine = std::max(0.f, Vector3::Dot(normal, -lightDirection.Normalized()));
-		return lambertCosine;
+		m_ShadingRateTileCounts.fill(0);
+		for (const ShadingRate rate : m_TileShadingRates)
+		{
+			++m_ShadingRateTileCounts[static_cast<size_t>(rate)];
+		}
 	}
 
-	void Software::SetMesh(Mesh* pMesh)
+	void Software::UpdateResolutionScale()
 	{
-		m_pVehicleMesh = pMesh;
+		const auto now{ std::chrono::steady_clock::now() };
+		const float frameTime{ std::chrono::duration<float>(now - m_LastRenderTime).count() };
+		const bool isFirstFrame{ m_LastRenderTime == std::chrono::steady_clock::time_point{} };
+		m_LastRenderTime = now;
+
+		// Long gaps are a stall or a switch from the hardware renderer, not the cost of a frame.
+		if (isFirstFrame || frameTime > 1.f)
+		{
+			return;
+		}
+		m_AverageFrameTime = m_AverageFrameTime > 0.f ? m_AverageFrameTime + (frameTime - m_AverageFrameTime) * 0.1f : frameTime;
+
+		if (!m_DynamicResolution)
+		{
+			m_ResolutionScale = 1.f;
+			return;
+		}
 
-		for (int i = 0; i < m_pVehicleMesh->m_VerticesIn.size(); ++i)
+		// Moves part of the way each frame and ignores a few percent of noise, so the size does not oscillate around the target.
+		const float ratio{ TargetFrameTime / m_AverageFrameTime };
+		if (ratio > 0.95f && ratio < 1.05f)
 		{
-			m_pVehicleMesh->m_VerticesOut.push_back(Vertex_Out{});
+			return;
 		}
+		const float desiredScale{ std::clamp(m_ResolutionScale * std::sqrt(ratio), MinResolutionScale, 1.f) };
+		m_ResolutionScale += (desiredScale - m_ResolutionScale) * 0.25f;
 	}
 
-	void Software::SetLight(Lights* pLight)
+	void Software::AddMesh(Mesh* pMesh)
 	{
-		m_pDirectionalLight = pLight;
+		SoftwareEffect* pEffect{ pMesh->GetSoftwareEffect() };
+		assert(pEffect && "Mesh has no software effect.");
+
+		for (int i = 0; i < pMesh->m_VerticesIn.size(); ++i)
+		{
+			pMesh->m_VerticesOut.push_back(Vertex_Out{});
+		}
+
+		const auto batchIt{ std::find_if(m_Batches.begin(), m_Batches.end(), [pEffect](const DrawBatch& batch) { return batch.pEffect == pEffect; }) };
+		if (batchIt != m_Batches.end())
+		{
+			batchIt->pMeshes.emplace_back(pMesh);
+			return;
+		}
+
+		DrawBatch batch{ pEffect, { pMesh } };
+		for (int slot = 0; slot < MaxFramesInFlight; ++slot)
+		{
+			batch.frames.emplace_back(BatchGeometry{ {}, TileBinner{ m_Width, m_Height } });
+		}
+		m_Batches.emplace_back(std::move(batch));
+
+		// Keeps the opaque batches in front of the transparent ones.
+		std::stable_partition(m_Batches.begin(), m_Batches.end(), [](const DrawBatch& batch) { return !batch.pEffect->IsTransparent(); });
 	}
 
-	void Software::SetTextures(Texture* pDiffuse, Texture* pNormal, Texture* pGloss, Texture* pSpecular)
+	void Software::SetShadowCaster(Mesh* pMesh)
 	{
-		m_pDiffuseVehicle = pDiffuse;
-		m_pNormalVehicle = pNormal;
-		m_pGlossVehicle = pGloss;
-		m_pSpecularVehicle = pSpecular;
+		m_pShadowCaster = pMesh;
 	}
 
 	void Software::CycleCullMode()
@@ -411,10 +833,12 @@ namespace dae
 		std::cout << (m_DepthBufferVisualized ? "Depth Buffer Visualize ON.\n" : "Depth Buffer Visualize OFF.\n");
 	}
 
-	void Software::ToggleNormalMap()
+	void Software::CycleDepthFormat()
 	{
-		m_ToggleNormalMap = !m_ToggleNormalMap;
-		std::cout << (m_ToggleNormalMap ? "Normal Map ON.\n" : "Normal Map OFF.\n");
+		m_DepthFormat = static_cast<DepthFormat>((static_cast<int>(m_DepthFormat) + 1) % DepthFormatCount);
+
+		const std::array<std::string, DepthFormatCount> formatNames{ "Depth Format: Float32.", "Depth Format: Reversed-Z Float32.", "Depth Format: Unorm24.", "Depth Format: Unorm16." };
+		std::cout << formatNames.at(static_cast<int>(m_DepthFormat)) << std::endl;
 	}
 
 	void Software::ToggleUniformBg()
@@ -428,18 +852,94 @@ namespace dae
 		std::cout << (m_ToggleBoundingBox ? "Bounding Box ON.\n" : "Bounding Box OFF.\n");
 	}
 
-	void Software::CycleShadingMode()
+	void Software::ToggleTransparentMeshes()
 	{
-		int count{ static_cast<int>(m_ShadingMode) };
-		count++;
-		if (count > 3)
+		m_ToggleTransparentMeshes = !m_ToggleTransparentMeshes;
+	}
+
+	void Software::ToggleShadows()
+	{
+		m_ToggleShadows = !m_ToggleShadows;
+		std::cout << (m_ToggleShadows ? "Shadows ON.\n" : "Shadows OFF.\n");
+	}
+
+	void Software::CycleShadingRateMode()
+	{
+		m_ShadingRateMode = static_cast<ShadingRateMode>((static_cast<int>(m_ShadingRateMode) + 1) % ShadingRateModeCount);
+
+		const std::array<std::string, ShadingRateModeCount> modeNames{ "Shading Rate: Full.", "Shading Rate: Coarse 2x2.", "Shading Rate: By Distance.", "Shading Rate: By Luminance Gradient." };
+		std::cout << modeNames.at(static_cast<int>(m_ShadingRateMode)) << std::endl;
+	}
+
+	void Software::CycleFramesInFlight()
+	{
+		m_FramesInFlight = m_FramesInFlight % MaxFramesInFlight + 1;
+		std::cout << "Frames In Flight: " << m_FramesInFlight << ".\n";
+	}
+
+	void Software::TogglePresentMode()
+	{
+		m_pPresenter->ToggleMode();
+	}
+
+	void Software::ToggleZeroCopyPresent()
+	{
+		m_ZeroCopyPresent = !m_ZeroCopyPresent;
+		std::cout << (m_ZeroCopyPresent ? "Zero-Copy Present ON.\n" : "Zero-Copy Present OFF.\n");
+	}
+
+	void Software::ToggleDynamicResolution()
+	{
+		m_DynamicResolution = !m_DynamicResolution;
+		std::cout << (m_DynamicResolution ? "Dynamic Resolution ON.\n" : "Dynamic Resolution OFF.\n");
+	}
+
+	void Software::WaitForPresents()
+	{
+		m_pPresenter->Flush();
+	}
+
+	void Software::SetStatsEnabled(bool isEnabled)
+	{
+		m_StatsEnabled = isEnabled;
+	}
+
+	void Software::PrintStats() const
+	{
+		size_t meshCount{};
+		for (const DrawBatch& batch : m_Batches)
 		{
-			count = 0;
+			meshCount += batch.pMeshes.size();
 		}
-		const auto castEnum = static_cast<ShadingModes>(count);
-		m_ShadingMode = castEnum;
+		std::cout << "Draw batches: " << m_Batches.size() << " (" << meshCount << " meshes)\n";
 
-		const std::array<std::string, 4> shadingNames{ "Shading Mode: Combined.", "Shading Mode: Observed Area.", "Shading Mode: Diffuse.", "Shading Mode: Specular." };
-		std::cout << shadingNames.at(count) << std::endl;
+		if (m_pStatsFrame)
+		{
+			std::cout << "Frame arena: " << m_pStatsFrame->arena.GetUsedBytes() / 1024 << " KB used of " << m_pStatsFrame->arena.GetCapacityBytes() / 1024 << " KB";
+#if defined(_DEBUG)
+			std::cout << " | Heap allocations in the last frame: " << m_FrameAllocationCount;
+#endif
+			std::cout << '\n';
+		}
+
+		std::cout << "Shading rate tiles: " << m_ShadingRateTileCounts[0] << " at 1x1, " << m_ShadingRateTileCounts[1] << " at 2x1, "
+			<< m_ShadingRateTileCounts[2] << " at 2x2, " << m_ShadingRateTileCounts[3] << " at 4x4\n";
+
+		std::cout << "Resolution: " << (m_pStatsFrame ? m_pStatsFrame->renderWidth : m_Width) << 'x' << (m_pStatsFrame ? m_pStatsFrame->renderHeight : m_Height)
+			<< " of " << m_Width << 'x' << m_Height << (m_DynamicResolution ? " (dynamic" : " (fixed") << ", frame time "
+			<< m_AverageFrameTime * 1000.f << " ms, target " << TargetFrameTime * 1000.f << " ms)\n";
+
+		std::cout << "Tile scheduling: " << m_TileWork.size() << " jobs, " << m_SplitTileCount << " tiles split, heaviest job "
+			<< static_cast<int>(m_HeaviestWorkShare * 100.f) << "% of the raster time\n";
+
+		if (m_pStatsFrame)
+		{
+			m_pStatsFrame->lights.PrintStats();
+			m_pStatsFrame->shadowMap.PrintStats();
+		}
+		std::cout << "Zero-copy present: " << (m_ZeroCopyPresent ? "ON" : "OFF") << ", " << m_ZeroCopyFrameCount << " of " << m_FrameNumber
+			<< " frames resolved straight into the window surface\n";
+		m_pPresenter->PrintStats();
+		JobSystem::GetInstance().PrintStats();
 	}
 }
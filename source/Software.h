@@ -1,8 +1,18 @@
 #pragma once
+#include <array>
+#include <vector>
+#include <chrono>
 #include "Mesh.h"
 #include "Camera.h"
 #include "Utils.h"
 #include "Lights.h"
+#include "ClusteredLights.h"
+#include "TileBinner.h"
+#include "ShadowMap.h"
+#include "SoftwareEffect.h"
+#include "ColorBuffer.h"
+#include "Presenter.h"
+#include "FrameArena.h"
 
 struct SDL_Window;
 struct SDL_Surface;
@@ -21,62 +31,201 @@ namespace dae
 		Software& operator=(const Software&) = delete;
 		Software& operator=(Software&&) noexcept = delete;
 
-		void Render(const Camera& camera) const;
-		void CycleShadingMode();
-		void SetMesh(Mesh* pMesh);
-		void SetLight(Lights* pLight);
-		void SetTextures(Texture* pDiffuse, Texture* pNormal, Texture* pGloss, Texture* pSpecular);
+		void Render(const Camera& camera);
+		// Reallocates the color, depth and back buffers for the new window size, nothing is reallocated per frame.
+		void Resize(int width, int height);
+		// Draws the mesh with its software effect, meshes sharing an effect are drawn as one batch.
+		void AddMesh(Mesh* pMesh);
+		void SetShadowCaster(Mesh* pMesh);
 		void CycleCullMode();
 		void VisualizeDepthBuffer();
-		void ToggleNormalMap();
+		void CycleDepthFormat();
 		void ToggleUniformBg();
 		void ToggleBoundingBox();
+		void ToggleTransparentMeshes();
+		void ToggleShadows();
+		void CycleShadingRateMode();
+		void CycleFramesInFlight();
+		void TogglePresentMode();
+		void ToggleZeroCopyPresent();
+		void ToggleDynamicResolution();
+		// Blocks until the window shows the last submitted frame, before something else draws to it.
+		void WaitForPresents();
+		void PrintStats() const;
+		// Counters only the stats read are skipped while they are not printed.
+		void SetStatsEnabled(bool isEnabled);
 
 	private:
 
-		enum class ShadingModes
+		// Up to three frames are in flight: the geometry of one, the raster of the one before and the present of the one before that.
+		// Every frame has its own slot of the state that lives from one stage into the next.
+		static constexpr int MaxFramesInFlight{ 3 };
+
+		// Triangle setup output of one frame slot of a batch. The triangles are in the frame's arena, the bins keep their capacity between frames.
+		struct BatchGeometry
+		{
+			std::span<RasterTriangle> triangles{};
+			TileBinner bins;
+		};
+
+		// The meshes of one effect, set up and binned together so a tile draws them with a single call into the effect.
+		struct DrawBatch
 		{
-			Combined, ObservedArea, Diffuse, Specular
+			SoftwareEffect* pEffect{};
+			std::vector<Mesh*> pMeshes{};
+			// One per frame slot.
+			std::vector<BatchGeometry> frames{};
+		};
+
+		enum class FrameStage
+		{
+			Free, Recorded, Rasterized
+		};
+
+		// What a frame carries from its geometry stage to its present.
+		// The mesh vertices are not part of it: triangle setup copies them into the RasterTriangles.
+		struct Frame
+		{
+			Frame(int slot, int width, int height, uint32_t pixelFormat);
+
+			int slot{};
+			uint64_t number{};
+			FrameStage stage{ FrameStage::Free };
+			// Transient data of every stage of the frame, reset when the slot records its next frame.
+			FrameArena arena{};
+
+			// Size the frame is rasterized at, the top left of the window sized buffers. Smaller than the window it is scaled up in the resolve.
+			int renderWidth{};
+			int renderHeight{};
+
+			RasterState state{};
+			ClusteredLights lights;
+			ShadowMap shadowMap{};
+			// The first directional light of the frame casts the shadow of the caster, NoShadowLight when none does.
+			uint32_t shadowLightIndex{ UINT32_MAX };
+
+			SDL_Surface* pBackBuffer{ nullptr };
+			// What the frame is resolved into and presented from: the window surface itself with zero-copy present, pBackBuffer otherwise.
+			SDL_Surface* pTarget{ nullptr };
 		};
 
 		SDL_Window* m_pWindow{};
 		int m_Width{};
 		int m_Height{};
 
-		SDL_Surface* m_pFrontBuffer{ nullptr };
-		SDL_Surface* m_pBackBuffer{ nullptr };
-		uint32_t* m_pBackBufferPixels{};
-		float* m_pDepthBufferPixels{};
+		Presenter* m_pPresenter{ nullptr };
+		// SDL format of the back buffers.
+		uint32_t m_SurfaceFormat{};
+		// Values of m_DepthFormat, the depth buffer is only ever read by the tile that writes it.
+		std::byte* m_pDepthBuffer{};
+		static constexpr size_t DepthFormatCount{ 4 };
+		DepthFormat m_DepthFormat{ DepthFormat::Float32 };
+		// The effects shade into float colors, each tile is resolved into the back buffer once it is finished.
+		ColorBuffer m_ColorBuffer;
+		PixelFormat m_PixelFormat{};
 
 		bool m_DepthBufferVisualized{ false };
 		bool m_UniformBg{ false };
-		bool m_ToggleNormalMap{ true };
 		bool m_ToggleBoundingBox{ false };
+		bool m_ToggleTransparentMeshes{ true };
+		bool m_ToggleShadows{ true };
 
-		Mesh* m_pVehicleMesh{ nullptr };
-		Texture* m_pDiffuseVehicle{ nullptr };
-		Texture* m_pNormalVehicle{ nullptr };
-		Texture* m_pGlossVehicle{ nullptr };
-		Texture* m_pSpecularVehicle{ nullptr };
-
-		ShadingModes m_ShadingMode{ ShadingModes::Combined };
 		Culling m_CurrentCullingMode{ Culling::Back };
 
-		Lights* m_pDirectionalLight{ nullptr };
+		// 1 renders every frame start to finish within Render, more overlap the stages of consecutive frames at a frame of latency each.
+		int m_FramesInFlight{ 1 };
+		uint64_t m_FrameNumber{};
+		uint64_t m_PresentedFrameNumber{};
+		// Resolves frames straight into the window surface, saving the copy of the present.
+		// Falls back to the back buffers when the window's format differs, or while the present of another frame could write the window surface.
+		bool m_ZeroCopyPresent{ false };
+		uint64_t m_ZeroCopyFrameCount{};
+		std::array<Frame*, MaxFramesInFlight> m_pFrames{};
+		// The frame PrintStats reports, the last one rasterized.
+		const Frame* m_pStatsFrame{ nullptr };
+		bool m_StatsEnabled{ false };
+
+		// Opaque batches first, the transparent ones are blended over them.
+		std::vector<DrawBatch> m_Batches{};
+
+		// How the opaque pixels of each tile pick their shading rate.
+		enum class ShadingRateMode
+		{
+			Full, Coarse, Distance, Luminance
+		};
+		static constexpr size_t ShadingRateModeCount{ 4 };
+		static constexpr size_t ShadingRateCount{ 4 };
+		// Nearest view depth from which a tile drops to 2x1, 2x2 and 4x4.
+		static constexpr std::array<float, ShadingRateCount - 1> DistanceRateThresholds{ 40.f, 55.f, 70.f };
+		// Luminance gradient of the previous frame under which a tile drops to 2x1, 2x2 and 4x4.
+		static constexpr std::array<float, ShadingRateCount - 1> LuminanceRateThresholds{ 0.06f, 0.025f, 0.008f };
+		ShadingRateMode m_ShadingRateMode{ ShadingRateMode::Full };
+		std::vector<ShadingRate> m_TileShadingRates{};
+		std::array<size_t, ShadingRateCount> m_ShadingRateTileCounts{};
+
+		// Scales the render size with the square root of how far the frame time is off the target, so the pixel count follows the time.
+		// Every buffer stays window sized, a smaller render size only uses the top left of them.
+		static constexpr float TargetFrameTime{ 1.f / 30.f };
+		static constexpr float MinResolutionScale{ 0.5f };
+		// Render sizes are a multiple of this, so small changes of the scale do not re-tile every frame.
+		static constexpr int ResolutionStep{ 8 };
+		// Output rows per job of the upscaling resolve.
+		static constexpr int UpscaleRowsPerJob{ 16 };
+		bool m_DynamicResolution{ false };
+		float m_ResolutionScale{ 1.f };
+		// Exponential average of the time between two Render calls.
+		float m_AverageFrameTime{};
+		std::chrono::steady_clock::time_point m_LastRenderTime{};
+
+		static constexpr uint32_t NoShadowLight{ UINT32_MAX };
+		Mesh* m_pShadowCaster{ nullptr };
+		// A bin's tile or a strip of it, one job of the raster stage.
+		struct TileWork
+		{
+			int tileIndex{};
+			Tile rect{};
+			float cost{};
+		};
+		// Estimated cost per pixel of bounding box a triangle covers in the tile, per triangle and per pixel resolved.
+		static constexpr float TriangleSetupCost{ 64.f };
+		static constexpr float ResolveCost{ 0.1f };
+		// Most expensive first. Heavy tiles are split into strips, so no single tile is still running when the rest is done.
+		std::vector<TileWork> m_TileWork{};
+		std::vector<int64_t> m_TileWorkNanoseconds{};
+		// Bin estimate and measured nanoseconds of every tile in the last raster, they calibrate the next estimate.
+		std::vector<float> m_TileEstimates{};
+		std::vector<float> m_TileNanoseconds{};
+		// Render size the tile timings were measured at, a resize moves every tile so they no longer apply.
+		int m_TileTimingWidth{};
+		int m_TileTimingHeight{};
+		// Clear state per tile: a tile with triangles clears its depth and color right before drawing them,
+		// one without is never cleared and gets the clear color in its resolve. Of the last raster until the next ScheduleTiles.
+		std::vector<uint8_t> m_TileHasTriangles{};
+		size_t m_SplitTileCount{};
+		float m_HeaviestWorkShare{};
+
+		// Heap allocations during the last Render, counted in debug builds only. Should be 0 once the arenas and capacities have settled.
+		uint64_t m_FrameAllocationCount{};
 
 		// Functions.
 
-		void VertexTransformationFunction(const std::vector<Mesh*>& mesh, const Camera& camera) const;
-		void PixelRenderLoop(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2) const;
-		float ZBufferValue(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2) const;
-		float WInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2) const;
-		Vector2 UVInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated) const;
-		Vector3 NormalInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated) const;
-		Vector3 TangentInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated) const;
-		Vector3 ViewDirInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated) const;
-		float Remap(float value, float oldRangeL, float oldRangeN, float newRangeL, float newRangeN) const;
-		ColorRGB PixelShading(const Vertex_Out& v) const;
-		float GetLambertCosine(const Vector3& normal, const Vector3& lightDirection) const;
+		void CreateBuffers();
+		void DestroyBuffers();
+		static size_t GetTriangleCount(const Mesh& mesh);
+		void SetupTriangles(const Mesh& mesh, std::span<const Vertex_Out> vertices, std::span<RasterTriangle> triangles, int width, int height) const;
+		void BinTriangles(std::span<const RasterTriangle> triangles, TileBinner& bins) const;
+		void RecordGeometry(Frame& frame, const Camera& camera);
+		void BeginRaster(Frame& frame);
+		SDL_Surface* GetRasterTarget(const Frame& frame) const;
+		void RasterizeFrame(Frame& frame);
+		void PresentFrame(Frame& frame);
+		void UpdateShadowMap(Frame& frame);
+		void RenderShadowMap(Frame& frame);
+		void ClearTile(const RasterState& state, const Tile& tile, const ColorRGB& clearColor);
+		void RenderTransparentTile(Frame& frame, int tileIndex, const Tile& tile, const RasterState& state) const;
+		void UpdateShadingRates(const Frame& frame);
+		void ScheduleTiles(Frame& frame);
+		void UpdateResolutionScale();
 
 	};
 
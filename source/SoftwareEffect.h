@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <span>
+#include <vector>
+#include "Camera.h"
+#include "Vertex.h"
+#include "Utils.h"
+#include "TileBinner.h"
+#include "ColorBuffer.h"
+
+namespace dae
+{
+	class Mesh;
+	class ClusteredLights;
+	class ShadowMap;
+
+	// Triangle after clipping and the NDC to raster conversion, with the pixel rectangle the rasterizer walks (max exclusive).
+	struct RasterTriangle
+	{
+		Vertex_Out v0{};
+		Vertex_Out v1{};
+		Vertex_Out v2{};
+		int minX{};
+		int minY{};
+		int maxX{};
+		int maxY{};
+		// Mean view depth, the key the transparent triangles are sorted on.
+		float sortDepth{};
+		bool isVisible{ false };
+	};
+
+	// Pixels one pixel shader invocation covers. Coarse rates broadcast the color to the covered pixels, depth and coverage stay per pixel.
+	enum class ShadingRate
+	{
+		Rate1x1, Rate2x1, Rate2x2, Rate4x4
+	};
+
+	// The 2x2 pixels an opaque pixel shader runs on, in the order top left, top right, bottom left, bottom right.
+	// Lanes outside the triangle or behind the depth buffer are helper lanes: interpolated, never shaded or written.
+	struct PixelQuad
+	{
+		std::array<Vertex_Out, 4> fragments{};
+		std::array<Vector3, 4> worldPositions{};
+		// Size of the coarse pixel, at coarse shading rates the derivatives span a coarse pixel instead of one pixel.
+		float ddxScale{ 1.f };
+		float ddyScale{ 1.f };
+
+		// Fine derivatives, the difference across the lane's row of the quad.
+		template<typename Attribute>
+		Attribute Ddx(Attribute Vertex_Out::* attribute, int lane) const
+		{
+			return (fragments[lane | 1].*attribute - fragments[lane & 2].*attribute) * ddxScale;
+		}
+
+		// Fine derivatives, the difference across the lane's column of the quad.
+		template<typename Attribute>
+		Attribute Ddy(Attribute Vertex_Out::* attribute, int lane) const
+		{
+			return (fragments[lane | 2].*attribute - fragments[lane & 1].*attribute) * ddyScale;
+		}
+	};
+
+	// What the depth buffer stores per pixel, each format is its own specialization of the depth test.
+	// Float32 is the NDC z, ReversedFloat32 the near plane over the view depth: 1 at the near plane towards 0 far away,
+	// where a float has its precision. The unorm formats quantize the NDC z, Unorm16 at half the memory traffic of the others.
+	enum class DepthFormat
+	{
+		Float32, ReversedFloat32, Unorm24, Unorm16
+	};
+
+	// Targets and frame wide state the raster core hands every effect.
+	struct RasterState
+	{
+		ColorBuffer* pColorBuffer{};
+		// Values of depthFormat.
+		void* pDepthBuffer{};
+		DepthFormat depthFormat{ DepthFormat::Float32 };
+		// Pixels per row of both buffers, padded past the render width.
+		int stride{};
+
+		// Of the tile being drawn, the raster core sets it before each tile.
+		ShadingRate shadingRate{ ShadingRate::Rate1x1 };
+
+		Culling cullMode{ Culling::Back };
+		bool isDepthVisualized{ false };
+		bool isBoundingBox{ false };
+
+		Vector3 cameraOrigin{};
+		float nearPlane{};
+		const ClusteredLights* pLights{};
+		const ShadowMap* pShadowMap{};
+		// Index into the lights of the one that casts the shadow map, UINT32_MAX when none does.
+		uint32_t shadowLightIndex{ UINT32_MAX };
+	};
+
+	// Software counterpart of Effect, a mesh is drawn with the effect bound to it.
+	// Effects plug their vertex and pixel stages into the raster loops of SoftwareRaster.h as template parameters,
+	// so the only virtual calls are once per mesh and once per tile of a batch, never per pixel.
+	class SoftwareEffect
+	{
+	public:
+
+		SoftwareEffect() = default;
+		virtual ~SoftwareEffect() = default;
+
+		SoftwareEffect(const SoftwareEffect&) = delete;
+		SoftwareEffect(SoftwareEffect&&) noexcept = delete;
+		SoftwareEffect& operator=(const SoftwareEffect&) = delete;
+		SoftwareEffect& operator=(SoftwareEffect&&) noexcept = delete;
+
+		// Transparent effects are blended after every opaque one, depth tested without writing depth.
+		virtual bool IsTransparent() const = 0;
+
+		// Once per frame before any draw, picks the specialization the frame's toggles need.
+		virtual void BeginFrame(const RasterState& state) = 0;
+
+		// Vertex stage of the whole mesh into its m_VerticesOut.
+		virtual void TransformVertices(Mesh& mesh, const Camera& camera) const = 0;
+
+		// Raster and pixel stages of the triangles of one tile, in the given order.
+		// The tile can be a strip of the bin's tile, the pixels outside it are left alone.
+		virtual void DrawTile(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const = 0;
+	};
+}
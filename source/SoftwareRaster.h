@@ -0,0 +1,518 @@
+#pragma once
+#include <bit>
+#include "Mesh.h"
+#include "SoftwareEffect.h"
+#include "JobSystem.h"
+
+namespace dae
+{
+	// The raster core the software effects are built from. Every stage is a template parameter,
+	// so an effect's vertex and pixel shaders are inlined into the loops that call them.
+	namespace SoftwareRaster
+	{
+		template<Culling CullMode>
+		inline bool IsInsideTriangle(float signedArea1, float signedArea2, float signedArea3)
+		{
+			if constexpr (CullMode == Culling::Back)
+			{
+				return signedArea1 > 0 && signedArea2 > 0 && signedArea3 > 0;
+			}
+			else if constexpr (CullMode == Culling::Front)
+			{
+				return signedArea1 < 0 && signedArea2 < 0 && signedArea3 < 0;
+			}
+			else
+			{
+				return (signedArea1 > 0 && signedArea2 > 0 && signedArea3 > 0) || (signedArea1 < 0 && signedArea2 < 0 && signedArea3 < 0);
+			}
+		}
+
+		inline float ZBufferValue(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2)
+		{
+			const float denominator = (1.0f / v0.position.z) * w0 + (1.0f / v1.position.z) * w1 + (1.0f / v2.position.z) * w2;
+			return (1 / denominator);
+		}
+
+		inline float WInterpolated(const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2)
+		{
+			const float denominator = (1.0f / v0.position.w) * w0 + (1.0f / v1.position.w) * w1 + (1.0f / v2.position.w) * w2;
+			return (1 / denominator);
+		}
+
+		// Perspective correct interpolation of any Vertex_Out attribute.
+		template<typename Attribute>
+		inline Attribute Interpolated(Attribute Vertex_Out::* attribute, const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float wInterpolated)
+		{
+			return ((v0.*attribute / v0.position.w) * w0 + (v1.*attribute / v1.position.w) * w1 + (v2.*attribute / v2.position.w) * w2) * wInterpolated;
+		}
+
+		inline float Remap(float value, float oldRangeL, float oldRangeN, float newRangeL, float newRangeN)
+		{
+			const float newVal{ std::clamp(value, oldRangeL, oldRangeN) };
+			return newRangeL + (newVal - oldRangeL) * (newRangeN - newRangeL) / (newRangeN - oldRangeL);
+		}
+
+		// Edge functions of a triangle in raster space, shared by every raster loop.
+		// The signed areas of a pixel to the edges are its barycentric weights times area.
+		struct TriangleEdges
+		{
+			explicit TriangleEdges(const RasterTriangle& triangle)
+				: p0{ triangle.v0.position.GetXY() }
+				, p1{ triangle.v1.position.GetXY() }
+				, p2{ triangle.v2.position.GetXY() }
+				, v0v1{ p1 - p0 }
+				, v1v2{ p2 - p1 }
+				, v2v0{ p0 - p2 }
+				, area{ Vector2::Cross(v0v1, p2 - p0) }
+			{
+			}
+
+			Vector2 p0{}, p1{}, p2{};
+			Vector2 v0v1{}, v1v2{}, v2v0{};
+			float area{};
+
+			// Cross of vertex to pixel and edge, signedArea2 weighs v0, signedArea3 v1 and signedArea1 v2.
+			void GetSignedAreas(const Vector2& pixel, float& signedArea1, float& signedArea2, float& signedArea3) const
+			{
+				signedArea1 = Vector2::Cross(v0v1, pixel - p0);
+				signedArea2 = Vector2::Cross(v1v2, pixel - p1);
+				signedArea3 = Vector2::Cross(v2v0, pixel - p2);
+			}
+		};
+
+		// Only the part of the triangle's bounding box inside the tile.
+		inline Tile ClipToTile(const RasterTriangle& triangle, const Tile& tile)
+		{
+			return Tile{ std::max(triangle.minX, tile.minX), std::max(triangle.minY, tile.minY), std::min(triangle.maxX, tile.maxX), std::min(triangle.maxY, tile.maxY) };
+		}
+
+		// The depth visualization shows this range of NDC z, whatever the format stores.
+		inline constexpr float VisualizedDepthMin{ 0.985f };
+
+		// Storage and depth test of a DepthFormat:
+		//   using Value, the type of a pixel in the depth buffer
+		//   static constexpr Value Cleared
+		//   static Value Encode(const RasterTriangle& triangle, float W0, float W1, float W2, float nearPlane), the value of a perspective pixel at the barycentric weights
+		//   static Value FromNdcZ(float z), the value of an NDC z interpolated by the caller
+		//   static bool IsCloser(Value depth, Value stored), the depth test
+		//   static float ToNdcZ(Value depth, float nearPlane)
+		template<DepthFormat Format>
+		struct Depth;
+
+		template<>
+		struct Depth<DepthFormat::Float32>
+		{
+			using Value = float;
+			static constexpr Value Cleared{ FLT_MAX };
+
+			static Value Encode(const RasterTriangle& triangle, float W0, float W1, float W2, float)
+			{
+				return ZBufferValue(triangle.v0, triangle.v1, triangle.v2, W0, W1, W2);
+			}
+
+			static Value FromNdcZ(float z) { return z; }
+			static bool IsCloser(Value depth, Value stored) { return depth < stored; }
+			static float ToNdcZ(Value depth, float) { return depth; }
+		};
+
+		// Interpolates 1 / w, which is linear in screen space, instead of the NDC z that has lost most of its precision by the time it is near 1.
+		// With the far plane at infinity the NDC z is 1 - near / w, so this is its complement and the test is greater than.
+		template<>
+		struct Depth<DepthFormat::ReversedFloat32>
+		{
+			using Value = float;
+			static constexpr Value Cleared{ 0.f };
+
+			static Value Encode(const RasterTriangle& triangle, float W0, float W1, float W2, float nearPlane)
+			{
+				return nearPlane * (W0 / triangle.v0.position.w + W1 / triangle.v1.position.w + W2 / triangle.v2.position.w);
+			}
+
+			static Value FromNdcZ(float z) { return 1.f - z; }
+			static bool IsCloser(Value depth, Value stored) { return depth > stored; }
+			static float ToNdcZ(Value depth, float) { return 1.f - depth; }
+		};
+
+		template<typename StoredValue, uint32_t MaxValue>
+		struct UnormDepth
+		{
+			using Value = StoredValue;
+			static constexpr Value Cleared{ MaxValue };
+
+			static Value Encode(const RasterTriangle& triangle, float W0, float W1, float W2, float)
+			{
+				return FromNdcZ(ZBufferValue(triangle.v0, triangle.v1, triangle.v2, W0, W1, W2));
+			}
+
+			static Value FromNdcZ(float z)
+			{
+				// Clamped before the conversion, which is undefined out of range. A NaN z ends up at the far plane.
+				if (!(z < 1.f))
+				{
+					return MaxValue;
+				}
+				return static_cast<Value>(std::max(z, 0.f) * static_cast<float>(MaxValue) + 0.5f);
+			}
+
+			static bool IsCloser(Value depth, Value stored) { return depth < stored; }
+			static float ToNdcZ(Value depth, float) { return static_cast<float>(depth) / static_cast<float>(MaxValue); }
+		};
+
+		// 24 bits in a 32 bit word like D24S8, the top byte is unused.
+		template<>
+		struct Depth<DepthFormat::Unorm24> : UnormDepth<uint32_t, (1u << 24) - 1> {};
+
+		template<>
+		struct Depth<DepthFormat::Unorm16> : UnormDepth<uint16_t, UINT16_MAX> {};
+
+		template<DepthFormat Format>
+		typename Depth<Format>::Value& DepthAt(const RasterState& state, int px, int py)
+		{
+			return static_cast<typename Depth<Format>::Value*>(state.pDepthBuffer)[py * state.stride + px];
+		}
+
+		template<DepthFormat Format>
+		void ClearDepth(const RasterState& state, const Tile& tile)
+		{
+			for (int py{ tile.minY }; py < tile.maxY; ++py)
+			{
+				std::fill_n(&DepthAt<Format>(state, tile.minX, py), tile.maxX - tile.minX, Depth<Format>::Cleared);
+			}
+		}
+
+		inline void ClearDepth(const RasterState& state, const Tile& tile)
+		{
+			switch (state.depthFormat)
+			{
+			case DepthFormat::ReversedFloat32:
+				ClearDepth<DepthFormat::ReversedFloat32>(state, tile);
+				break;
+			case DepthFormat::Unorm24:
+				ClearDepth<DepthFormat::Unorm24>(state, tile);
+				break;
+			case DepthFormat::Unorm16:
+				ClearDepth<DepthFormat::Unorm16>(state, tile);
+				break;
+			default:
+				ClearDepth<DepthFormat::Float32>(state, tile);
+				break;
+			}
+		}
+
+		// Projection, world space normal and tangent, and the unnormalized direction to the camera.
+		struct StandardVertexShader
+		{
+			static Vertex_Out Shade(const Vertex_In& vertex, const Matrix& worldMatrix, const Matrix& worldViewProjectionMatrix, const Vector3& cameraOrigin)
+			{
+				// Projection.
+				Vector4 projectedVertex{ worldViewProjectionMatrix.TransformPoint(vertex.position.x, vertex.position.y, vertex.position.z, 1) };
+
+				// World space normal calculation.
+				const Vector3 worldSpaceNormal{ worldMatrix.TransformVector(vertex.normal).Normalized() };
+
+				// Tangent calculation.
+				const Vector3 tangent{ worldMatrix.TransformVector(vertex.tangent).Normalized() };
+
+				// View Direction Calculation.
+				const Vector3 viewDirection{ cameraOrigin - worldMatrix.TransformPoint(vertex.position) };
+
+				// Perspective Divide.
+				projectedVertex.x /= projectedVertex.w;
+				projectedVertex.y /= projectedVertex.w;
+				projectedVertex.z /= projectedVertex.w;
+
+				return Vertex_Out{ projectedVertex, vertex.color, vertex.uv, worldSpaceNormal, tangent, viewDirection };
+			}
+		};
+
+		// Vertices and triangles per job of the vertex and setup stages, tiles are one job each.
+		inline constexpr size_t VerticesPerJob{ 512 };
+		inline constexpr size_t TrianglesPerJob{ 256 };
+
+		// Runs VertexShader::Shade over every vertex of the mesh into m_VerticesOut.
+		template<typename VertexShader>
+		void TransformVertices(Mesh& mesh, const Camera& camera)
+		{
+			const Matrix worldViewProjectionMatrix{ mesh.m_WorldMatrix * camera.viewMatrix * camera.projectionMatrix };
+
+			JobSystem::GetInstance().ParallelFor(static_cast<size_t>(0), mesh.m_VerticesIn.size(), VerticesPerJob, [&](const size_t i)
+			{
+				mesh.m_VerticesOut[i] = VertexShader::Shade(mesh.m_VerticesIn[i], mesh.m_WorldMatrix, worldViewProjectionMatrix, camera.origin);
+			});
+		}
+
+		// Perspective correct attributes of the pixel at the barycentric weights, the pixel shader's input.
+		template<bool UsesTangent>
+		inline void InterpolateFragment(const RasterTriangle& triangle, int px, int py, float W0, float W1, float W2, float zBufferValue, const Vector3& cameraOrigin, Vertex_Out& fragment, Vector3& worldPosition)
+		{
+			const Vertex_Out& v0{ triangle.v0 };
+			const Vertex_Out& v1{ triangle.v1 };
+			const Vertex_Out& v2{ triangle.v2 };
+
+			const float wInterpolated{ WInterpolated(v0, v1, v2, W0, W1, W2) };
+			fragment.position = Vector4{ static_cast<float>(px), static_cast<float>(py), zBufferValue, wInterpolated };
+			fragment.color = ColorRGB{};
+			fragment.uv = Interpolated(&Vertex_Out::uv, v0, v1, v2, W0, W1, W2, wInterpolated);
+			fragment.normal = Interpolated(&Vertex_Out::normal, v0, v1, v2, W0, W1, W2, wInterpolated).Normalized();
+			if constexpr (UsesTangent)
+			{
+				fragment.tangent = Interpolated(&Vertex_Out::tangent, v0, v1, v2, W0, W1, W2, wInterpolated).Normalized();
+			}
+
+			// The vertex view direction is the unnormalized vector to the camera, the point lights need the world position it leads back to.
+			const Vector3 toCamera{ Interpolated(&Vertex_Out::viewDirection, v0, v1, v2, W0, W1, W2, wInterpolated) };
+			worldPosition = cameraOrigin - toCamera;
+			fragment.viewDirection = toCamera.Normalized();
+		}
+
+		// Depth tested and depth writing raster loop, the part of the triangle inside the tile, shaded a 2x2 quad at a time.
+		// PixelShader provides:
+		//   static constexpr bool UsesTangent
+		//   bool NeedsDerivatives() const
+		//   ColorRGB Shade(const PixelQuad& quad, int lane) const
+		// Helper lanes are only interpolated when NeedsDerivatives() is true, otherwise the quad's derivatives are undefined.
+		// At state.shadingRate coarser than 1x1 Shade runs once per coarse pixel, on its first covered lane.
+		template<typename PixelShader, bool BoundingBox, bool DepthVisualized, Culling CullMode, DepthFormat Format>
+		void RasterizeOpaque(const RasterState& state, const RasterTriangle& triangle, const Tile& tile, const PixelShader& shader)
+		{
+			const auto [minX, minY, maxX, maxY] { ClipToTile(triangle, tile) };
+
+			if constexpr (BoundingBox)
+			{
+				for (int py{ minY }; py < maxY; ++py)
+				{
+					for (int px{ minX }; px < maxX; ++px)
+					{
+						state.pColorBuffer->Write(px + (py * state.stride), ColorRGB{ 1, 1, 1 });
+					}
+				}
+				return;
+			}
+
+			const bool needsDerivatives{ !DepthVisualized && shader.NeedsDerivatives() };
+
+			const TriangleEdges edges{ triangle };
+
+			// The depth view shows every pixel.
+			const ShadingRate rate{ DepthVisualized ? ShadingRate::Rate1x1 : state.shadingRate };
+
+			PixelQuad quad{};
+			quad.ddxScale = rate == ShadingRate::Rate1x1 ? 1.f : rate == ShadingRate::Rate4x4 ? 4.f : 2.f;
+			quad.ddyScale = rate == ShadingRate::Rate2x2 ? 2.f : rate == ShadingRate::Rate4x4 ? 4.f : 1.f;
+			std::array<float, 4> W0{}, W1{}, W2{};
+			std::array<typename Depth<Format>::Value, 4> depths{};
+
+			const auto interpolateLanes = [&](int qx, int qy, int lanes)
+			{
+				for (int lane{}; lane < 4; ++lane)
+				{
+					if (needsDerivatives || (lanes & (1 << lane)))
+					{
+						InterpolateFragment<PixelShader::UsesTangent>(triangle, qx + (lane & 1), qy + (lane >> 1), W0[lane], W1[lane], W2[lane],
+							Depth<Format>::ToNdcZ(depths[lane], state.nearPlane), state.cameraOrigin, quad.fragments[lane], quad.worldPositions[lane]);
+					}
+				}
+			};
+
+			//Update Color in Buffer, the resolve tonemaps it
+			const auto writeLanes = [&](int qx, int qy, int lanes, const ColorRGB& color)
+			{
+				for (int lane{}; lane < 4; ++lane)
+				{
+					if (lanes & (1 << lane))
+					{
+						state.pColorBuffer->Write((qx + (lane & 1)) + ((qy + (lane >> 1)) * state.stride), color);
+					}
+				}
+			};
+
+			// Quads start on even pixels and 4x4 coarse pixels on multiples of 4.
+			// Tiles are a multiple of 4 wide, so neither straddles two tiles.
+			const int blockSize{ rate == ShadingRate::Rate4x4 ? 4 : 2 };
+			for (int by{ minY & ~(blockSize - 1) }; by < maxY; by += blockSize)
+			{
+				for (int bx{ minX & ~(blockSize - 1) }; bx < maxX; bx += blockSize)
+				{
+					// The color of a 2x2 or 4x4 coarse pixel, shaded by its first quad with a shaded lane.
+					bool isBlockShaded{ false };
+					ColorRGB blockColor{};
+
+					for (int qy{ by }; qy < by + blockSize && qy < maxY; qy += 2)
+					{
+						for (int qx{ bx }; qx < bx + blockSize && qx < maxX; qx += 2)
+						{
+							// Coverage, depth test and depth write of the four lanes, always at full rate.
+							int shadedLanes{};
+							for (int lane{}; lane < 4; ++lane)
+							{
+								const int px{ qx + (lane & 1) };
+								const int py{ qy + (lane >> 1) };
+								const Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
+
+								float signedArea1{}, signedArea2{}, signedArea3{};
+								edges.GetSignedAreas(pixel, signedArea1, signedArea2, signedArea3);
+
+								// Helper lanes get the weights too, extrapolated outside the triangle.
+								W0[lane] = signedArea2 / edges.area;
+								W1[lane] = signedArea3 / edges.area;
+								W2[lane] = signedArea1 / edges.area;
+
+								const bool isInRectangle{ px >= minX && px < maxX && py >= minY && py < maxY };
+								if (!isInRectangle || !IsInsideTriangle<CullMode>(signedArea1, signedArea2, signedArea3))
+								{
+									continue;
+								}
+
+								// Only covered lanes, the weights of a helper lane are extrapolated and can put its depth anywhere.
+								depths[lane] = Depth<Format>::Encode(triangle, W0[lane], W1[lane], W2[lane], state.nearPlane);
+
+								auto& depth{ DepthAt<Format>(state, px, py) };
+								if (Depth<Format>::IsCloser(depths[lane], depth))
+								{
+									depth = depths[lane];
+									shadedLanes |= 1 << lane;
+								}
+							}
+
+							if (shadedLanes == 0)
+							{
+								continue;
+							}
+
+							if constexpr (DepthVisualized)
+							{
+								for (int lane{}; lane < 4; ++lane)
+								{
+									if (shadedLanes & (1 << lane))
+									{
+										const float z{ Depth<Format>::ToNdcZ(depths[lane], state.nearPlane) };
+										writeLanes(qx, qy, 1 << lane, ColorRGB{ 1, 1, 1 } * Remap(z, VisualizedDepthMin, 1.f, 0.f, 1.f));
+									}
+								}
+							}
+							else if (rate == ShadingRate::Rate1x1)
+							{
+								interpolateLanes(qx, qy, shadedLanes);
+								for (int lane{}; lane < 4; ++lane)
+								{
+									if (shadedLanes & (1 << lane))
+									{
+										writeLanes(qx, qy, 1 << lane, shader.Shade(quad, lane));
+									}
+								}
+							}
+							else if (rate == ShadingRate::Rate2x1)
+							{
+								// One invocation per row of the quad, on its first shaded lane.
+								const int topLanes{ shadedLanes & 0b0011 };
+								const int bottomLanes{ shadedLanes & 0b1100 };
+								const int topLane{ std::countr_zero(static_cast<unsigned>(topLanes)) };
+								const int bottomLane{ std::countr_zero(static_cast<unsigned>(bottomLanes)) };
+								interpolateLanes(qx, qy, (topLanes ? 1 << topLane : 0) | (bottomLanes ? 1 << bottomLane : 0));
+								if (topLanes)
+								{
+									writeLanes(qx, qy, topLanes, shader.Shade(quad, topLane));
+								}
+								if (bottomLanes)
+								{
+									writeLanes(qx, qy, bottomLanes, shader.Shade(quad, bottomLane));
+								}
+							}
+							else
+							{
+								if (!isBlockShaded)
+								{
+									const int lane{ std::countr_zero(static_cast<unsigned>(shadedLanes)) };
+									interpolateLanes(qx, qy, 1 << lane);
+									blockColor = shader.Shade(quad, lane);
+									isBlockShaded = true;
+								}
+								writeLanes(qx, qy, shadedLanes, blockColor);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Depth tested raster loop that never writes depth, blending into the color buffer with
+		// SrcBlend = SRC_ALPHA and DestBlend = INV_SRC_ALPHA.
+		// PixelShader provides:
+		//   ColorRGB Shade(const Vertex_Out& pixel, float& alpha) const
+		template<typename PixelShader, Culling CullMode, DepthFormat Format>
+		void RasterizeBlended(const RasterState& state, const RasterTriangle& triangle, const Tile& tile, const PixelShader& shader)
+		{
+			const Vertex_Out& v0{ triangle.v0 };
+			const Vertex_Out& v1{ triangle.v1 };
+			const Vertex_Out& v2{ triangle.v2 };
+
+			const TriangleEdges edges{ triangle };
+			const auto [minX, minY, maxX, maxY] { ClipToTile(triangle, tile) };
+
+			for (int py{ minY }; py < maxY; ++py)
+			{
+				for (int px{ minX }; px < maxX; ++px)
+				{
+					const Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
+					float signedArea1{}, signedArea2{}, signedArea3{};
+					edges.GetSignedAreas(pixel, signedArea1, signedArea2, signedArea3);
+					if (!IsInsideTriangle<CullMode>(signedArea1, signedArea2, signedArea3))
+					{
+						continue;
+					}
+
+					const float W0{ signedArea2 / edges.area };
+					const float W1{ signedArea3 / edges.area };
+					const float W2{ signedArea1 / edges.area };
+
+					const auto depth{ Depth<Format>::Encode(triangle, W0, W1, W2, state.nearPlane) };
+					if (!Depth<Format>::IsCloser(depth, DepthAt<Format>(state, px, py)))
+					{
+						continue;
+					}
+
+					const float wInterpolated{ WInterpolated(v0, v1, v2, W0, W1, W2) };
+					const Vector4 pixelPos{ static_cast<float>(px), static_cast<float>(py), Depth<Format>::ToNdcZ(depth, state.nearPlane), wInterpolated };
+					const Vertex_Out pixelVertex{ pixelPos, ColorRGB{}, Interpolated(&Vertex_Out::uv, v0, v1, v2, W0, W1, W2, wInterpolated) };
+
+					float alpha{};
+					const ColorRGB source{ shader.Shade(pixelVertex, alpha) };
+
+					const int index{ py * state.stride + px };
+					state.pColorBuffer->Write(index, source * alpha + state.pColorBuffer->Read(index) * (1.f - alpha));
+				}
+			}
+		}
+
+		// Depth only raster loop of an orthographic pass, the shadow map: nothing is interpolated but the depth.
+		// Without a perspective divide the NDC z is linear in raster space, so it is interpolated as is instead of through Encode.
+		template<Culling CullMode, DepthFormat Format>
+		void RasterizeDepthOnly(const RasterState& state, const RasterTriangle& triangle, const Tile& tile)
+		{
+			const TriangleEdges edges{ triangle };
+			const auto [minX, minY, maxX, maxY] { ClipToTile(triangle, tile) };
+
+			for (int py{ minY }; py < maxY; ++py)
+			{
+				for (int px{ minX }; px < maxX; ++px)
+				{
+					const Vector2 pixel{ static_cast<float>(px), static_cast<float>(py) };
+					float signedArea1{}, signedArea2{}, signedArea3{};
+					edges.GetSignedAreas(pixel, signedArea1, signedArea2, signedArea3);
+					if (!IsInsideTriangle<CullMode>(signedArea1, signedArea2, signedArea3))
+					{
+						continue;
+					}
+
+					const float z{ (signedArea2 * triangle.v0.position.z + signedArea3 * triangle.v1.position.z + signedArea1 * triangle.v2.position.z) / edges.area };
+					const auto depth{ Depth<Format>::FromNdcZ(z) };
+					auto& storedDepth{ DepthAt<Format>(state, px, py) };
+					if (Depth<Format>::IsCloser(depth, storedDepth))
+					{
+						storedDepth = depth;
+					}
+				}
+			}
+		}
+	}
+}
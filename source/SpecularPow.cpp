@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "SpecularPow.h"
+
+#include <array>
+#include <string>
+
+namespace dae
+{
+	SpecularLut::SpecularLut(float maxExponent)
+		: m_MaxExponent(maxExponent)
+	{
+		m_Table.resize(static_cast<size_t>(CosineResolution) * GlossResolution);
+
+		for (int glossIndex = 0; glossIndex < GlossResolution; ++glossIndex)
+		{
+			const float exponent{ m_MaxExponent * static_cast<float>(glossIndex) / static_cast<float>(GlossResolution - 1) };
+			for (int cosineIndex = 0; cosineIndex < CosineResolution; ++cosineIndex)
+			{
+				const float cosAlpha{ static_cast<float>(cosineIndex) / static_cast<float>(CosineResolution - 1) };
+				m_Table[glossIndex * CosineResolution + cosineIndex] = std::pow(cosAlpha, exponent);
+			}
+		}
+	}
+
+	float SpecularLut::Sample(float cosAlpha, float gloss) const
+	{
+		return _mm_cvtss_f32(Sample(_mm_set_ss(cosAlpha), _mm_set_ss(gloss)));
+	}
+
+	__m128 SpecularLut::Sample(__m128 cosAlpha, __m128 gloss) const
+	{
+		const __m128 zero{ _mm_setzero_ps() };
+		const __m128 one{ _mm_set1_ps(1.f) };
+
+		// Table space, the last cell is clamped so the right and upper neighbour always exist.
+		const __m128 u{ _mm_mul_ps(_mm_min_ps(_mm_max_ps(cosAlpha, zero), one), _mm_set1_ps(static_cast<float>(CosineResolution - 1))) };
+		const __m128 v{ _mm_mul_ps(_mm_min_ps(_mm_max_ps(gloss, zero), one), _mm_set1_ps(static_cast<float>(GlossResolution - 1))) };
+		const __m128 cellU{ _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(u)), _mm_set1_ps(static_cast<float>(CosineResolution - 2))) };
+		const __m128 cellV{ _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(v)), _mm_set1_ps(static_cast<float>(GlossResolution - 2))) };
+		const __m128 fracU{ _mm_sub_ps(u, cellU) };
+		const __m128 fracV{ _mm_sub_ps(v, cellV) };
+
+		alignas(16) int cellIndices[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(cellIndices),
+			_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(cellV, _mm_set1_ps(static_cast<float>(CosineResolution))), cellU)));
+
+		// SSE2 has no gather, the four corners are loaded per lane.
+		alignas(16) float corners[4][4];
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			const float* pCell{ m_Table.data() + cellIndices[lane] };
+			corners[0][lane] = pCell[0];
+			corners[1][lane] = pCell[1];
+			corners[2][lane] = pCell[CosineResolution];
+			corners[3][lane] = pCell[CosineResolution + 1];
+		}
+
+		const __m128 bottom{ _mm_add_ps(_mm_load_ps(corners[0]), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(corners[1]), _mm_load_ps(corners[0])), fracU)) };
+		const __m128 top{ _mm_add_ps(_mm_load_ps(corners[2]), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(corners[3]), _mm_load_ps(corners[2])), fracU)) };
+		return _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(top, bottom), fracV));
+	}
+
+	namespace SpecularPow
+	{
+		void PrintErrorReport(const SpecularLut& lut)
+		{
+			constexpr int cosineSamples{ 1024 };
+			constexpr int glossSamples{ 64 };
+			// Relative errors are only meaningful where the lobe is visible at all.
+			constexpr float relativeErrorThreshold{ 1e-3f };
+
+			// Samples in between the table entries, where the table is least accurate.
+			std::vector<float> cosines{};
+			std::vector<float> glosses{};
+			cosines.reserve(cosineSamples * glossSamples);
+			glosses.reserve(cosineSamples * glossSamples);
+			for (int glossIndex = 0; glossIndex < glossSamples; ++glossIndex)
+			{
+				for (int cosineIndex = 0; cosineIndex < cosineSamples; ++cosineIndex)
+				{
+					cosines.emplace_back((static_cast<float>(cosineIndex) + 0.5f) / static_cast<float>(cosineSamples));
+					glosses.emplace_back((static_cast<float>(glossIndex) + 0.5f) / static_cast<float>(glossSamples));
+				}
+			}
+
+			const __m128 maxExponent{ _mm_set1_ps(lut.GetMaxExponent()) };
+			auto evaluate = [&](SpecularAccuracy accuracy, size_t i) -> __m128
+			{
+				const __m128 cosAlpha{ _mm_loadu_ps(&cosines[i]) };
+				const __m128 gloss{ _mm_loadu_ps(&glosses[i]) };
+				switch (accuracy)
+				{
+				case SpecularAccuracy::Fast:
+					return Fast(cosAlpha, _mm_mul_ps(gloss, maxExponent));
+				case SpecularAccuracy::LookupTable:
+					return lut.Sample(cosAlpha, gloss);
+				default:
+					return Exact(cosAlpha, _mm_mul_ps(gloss, maxExponent));
+				}
+			};
+
+			std::cout << "Specular pow vs std::pow, cosAlpha 0..1, exponent 0.." << lut.GetMaxExponent() << ":\n";
+
+			const std::array<std::string, 3> accuracyNames{ "Exact", "Fast", "Lookup Table" };
+			for (int accuracyIndex = 0; accuracyIndex < 3; ++accuracyIndex)
+			{
+				const auto accuracy{ static_cast<SpecularAccuracy>(accuracyIndex) };
+
+				double maxAbsoluteError{};
+				double sumAbsoluteError{};
+				double maxRelativeError{};
+				alignas(16) float results[4];
+				for (size_t i = 0; i < cosines.size(); i += 4)
+				{
+					_mm_store_ps(results, evaluate(accuracy, i));
+					for (int lane = 0; lane < 4; ++lane)
+					{
+						const double reference{ std::pow(static_cast<double>(cosines[i + lane]), static_cast<double>(glosses[i + lane] * lut.GetMaxExponent())) };
+						const double absoluteError{ std::abs(static_cast<double>(results[lane]) - reference) };
+						maxAbsoluteError = std::max(maxAbsoluteError, absoluteError);
+						sumAbsoluteError += absoluteError;
+						if (reference > relativeErrorThreshold)
+						{
+							maxRelativeError = std::max(maxRelativeError, absoluteError / reference);
+						}
+					}
+				}
+
+				constexpr int timingPasses{ 16 };
+				__m128 sink{ _mm_setzero_ps() };
+				const uint64_t start{ SDL_GetPerformanceCounter() };
+				for (int pass = 0; pass < timingPasses; ++pass)
+				{
+					for (size_t i = 0; i < cosines.size(); i += 4)
+					{
+						sink = _mm_add_ps(sink, evaluate(accuracy, i));
+					}
+				}
+				const uint64_t end{ SDL_GetPerformanceCounter() };
+				const double nanoSeconds{ static_cast<double>(end - start) * 1e9 / static_cast<double>(SDL_GetPerformanceFrequency()) };
+				const double evaluations{ static_cast<double>(cosines.size()) * timingPasses };
+
+				std::cout << "  " << accuracyNames[accuracyIndex]
+					<< " | Max abs error: " << maxAbsoluteError
+					<< " | Mean abs error: " << sumAbsoluteError / static_cast<double>(cosines.size())
+					<< " | Max rel error: " << maxRelativeError
+					<< " | " << nanoSeconds / evaluations << " ns/eval"
+					<< (_mm_cvtss_f32(sink) < 0.f ? " " : "") << '\n';
+			}
+		}
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include <emmintrin.h> // SSE2
+
+namespace dae
+{
+	// How the Phong lobe pow(cosAlpha, exponent) is evaluated.
+	enum class SpecularAccuracy
+	{
+		Exact, Fast, LookupTable
+	};
+
+	// Specular exponent evaluation, 4 lanes at a time with SSE.
+	// The scalar overloads run a single lane, so they give exactly the same results as the vector ones.
+	namespace SpecularPow
+	{
+		// std::pow per lane, the reference.
+		inline __m128 Exact(__m128 base, __m128 exponent)
+		{
+			alignas(16) float bases[4];
+			alignas(16) float exponents[4];
+			_mm_store_ps(bases, base);
+			_mm_store_ps(exponents, exponent);
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				bases[lane] = std::pow(bases[lane], exponents[lane]);
+			}
+			return _mm_load_ps(bases);
+		}
+
+		// exp2(exponent * log2(base)) with polynomial approximations, for bases in [0, 1] and positive exponents.
+		inline __m128 Fast(__m128 base, __m128 exponent)
+		{
+			const __m128 one{ _mm_set1_ps(1.f) };
+
+			// log2: the float exponent bits give the integer part, the mantissa m in [1, 2) the fraction
+			// through log2(m) = 2 / ln(2) * atanh((m - 1) / (m + 1)), which converges quickly since the argument is at most 1/3.
+			// Zero is clamped to the smallest normal float so pow(0, 0) stays 1 and pow(0, e) underflows to 0.
+			const __m128 clampedBase{ _mm_max_ps(base, _mm_set1_ps(1.17549435e-38f)) };
+			const __m128i bits{ _mm_castps_si128(clampedBase) };
+			const __m128 integerPart{ _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127))) };
+			const __m128 mantissa{ _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000))) };
+
+			const __m128 t{ _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one)) };
+			const __m128 t2{ _mm_mul_ps(t, t) };
+			__m128 series{ _mm_set1_ps(1.f / 9.f) };
+			series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.f / 7.f));
+			series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.f / 5.f));
+			series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.f / 3.f));
+			series = _mm_add_ps(_mm_mul_ps(series, t2), one);
+			const __m128 log2Base{ _mm_add_ps(integerPart, _mm_mul_ps(_mm_mul_ps(series, t), _mm_set1_ps(2.88539008f))) };
+
+			// exp2: round to the nearest integer for the float exponent bits, the fraction in [-0.5, 0.5] goes through a polynomial.
+			const __m128 power{ _mm_min_ps(_mm_max_ps(_mm_mul_ps(exponent, log2Base), _mm_set1_ps(-126.f)), _mm_set1_ps(127.f)) };
+			const __m128i roundedPower{ _mm_cvtps_epi32(power) };
+			const __m128 fraction{ _mm_sub_ps(power, _mm_cvtepi32_ps(roundedPower)) };
+
+			__m128 polynomial{ _mm_set1_ps(1.33335581e-3f) };
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, fraction), _mm_set1_ps(9.61812911e-3f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, fraction), _mm_set1_ps(5.55041087e-2f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, fraction), _mm_set1_ps(2.40226507e-1f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, fraction), _mm_set1_ps(6.93147181e-1f));
+			polynomial = _mm_add_ps(_mm_mul_ps(polynomial, fraction), one);
+
+			const __m128 scale{ _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(roundedPower, _mm_set1_epi32(127)), 23)) };
+			const __m128 result{ _mm_mul_ps(polynomial, scale) };
+
+			// The clamp above keeps the bits valid, flush what really underflowed.
+			return _mm_and_ps(result, _mm_cmpgt_ps(power, _mm_set1_ps(-126.f)));
+		}
+
+		inline float Exact(float base, float exponent)
+		{
+			return std::pow(base, exponent);
+		}
+
+		inline float Fast(float base, float exponent)
+		{
+			return _mm_cvtss_f32(Fast(_mm_set_ss(base), _mm_set_ss(exponent)));
+		}
+	}
+
+	// pow(cosAlpha, gloss * maxExponent) tabulated over cosAlpha and gloss in [0, 1], sampled bilinearly.
+	// The exponent axis is the gloss map value, so it matches a shader that scales the gloss map by a fixed shininess.
+	class SpecularLut final
+	{
+	public:
+
+		static constexpr int CosineResolution{ 256 };
+		static constexpr int GlossResolution{ 32 };
+
+		explicit SpecularLut(float maxExponent);
+
+		float GetMaxExponent() const { return m_MaxExponent; }
+
+		float Sample(float cosAlpha, float gloss) const;
+		__m128 Sample(__m128 cosAlpha, __m128 gloss) const;
+
+	private:
+
+		float m_MaxExponent{};
+		// Row per gloss value, CosineResolution entries per row.
+		std::vector<float> m_Table{};
+	};
+
+	namespace SpecularPow
+	{
+		// Prints the error of every accuracy level against std::pow over the (cosAlpha, gloss) range of the lookup table,
+		// and what a single evaluation costs.
+		void PrintErrorReport(const SpecularLut& lut);
+	}
+}
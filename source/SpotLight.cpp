@@ -0,0 +1,51 @@
+#include "pch.h"
+#include "SpotLight.h"
+
+namespace dae
+{
+
+	SpotLight::SpotLight(const Vector3& position, const Vector3& direction, float range, float innerConeAngle, float outerConeAngle, float lightIntensity)
+		: m_Position{ position }
+		, m_Direction{ direction.Normalized() }
+		, m_Range{ range }
+		, m_InnerConeCos{ cosf(innerConeAngle * 0.5f * TO_RADIANS) }
+		, m_OuterConeCos{ cosf(outerConeAngle * 0.5f * TO_RADIANS) }
+		, m_LightIntensity{ lightIntensity }
+	{
+	}
+
+	LightType SpotLight::GetType() const
+	{
+		return LightType::Spot;
+	}
+
+	Vector3 SpotLight::GetDirection() const
+	{
+		return m_Direction;
+	}
+
+	float SpotLight::GetlightIntensity() const
+	{
+		return m_LightIntensity;
+	}
+
+	Vector3 SpotLight::GetPosition() const
+	{
+		return m_Position;
+	}
+
+	float SpotLight::GetRange() const
+	{
+		return m_Range;
+	}
+
+	float SpotLight::GetInnerConeCos() const
+	{
+		return m_InnerConeCos;
+	}
+
+	float SpotLight::GetOuterConeCos() const
+	{
+		return m_OuterConeCos;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "Lights.h"
+
+namespace dae
+{
+	class SpotLight : public Lights
+	{
+	public:
+		// The cone angles are the full opening angles in degrees.
+		SpotLight(const Vector3& position, const Vector3& direction, float range, float innerConeAngle, float outerConeAngle, float lightIntensity);
+		~SpotLight() override = default;
+
+		SpotLight(const SpotLight&) = default;
+		SpotLight(SpotLight&&) noexcept = default;
+		SpotLight& operator=(const SpotLight&) = default;
+		SpotLight& operator=(SpotLight&&) noexcept = default;
+
+		virtual LightType GetType() const override;
+		virtual Vector3 GetDirection() const override;
+		virtual float GetlightIntensity() const override;
+		virtual Vector3 GetPosition() const override;
+		virtual float GetRange() const override;
+		virtual float GetInnerConeCos() const override;
+		virtual float GetOuterConeCos() const override;
+
+	private:
+		Vector3 m_Position;
+		Vector3 m_Direction;
+		float m_Range;
+		float m_InnerConeCos;
+		float m_OuterConeCos;
+		float m_LightIntensity;
+
+	};
+}
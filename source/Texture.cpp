@@ -1,22 +1,34 @@
 #include "pch.h"
 #include "Texture.h"
 #include "Vector2.h"
+#include "Sampler.h"
 #include <algorithm>
 #include <SDL_image.h>
 
 namespace dae
 {
 	Texture::Texture(const std::string& path, ID3D11Device* pDevice)
+		: Texture(IMG_Load(path.c_str()), pDevice, path)
 	{
-		SDL_Surface* pSurface = IMG_Load(path.c_str());
-		m_pSurface = pSurface;
-		m_pSurfacePixels = static_cast<uint32_t*>(pSurface->pixels);
+	}
+
+	Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice, const std::string& path)
+		: m_MipLevels(CalculateMipCount(pSurface->w, pSurface->h))
+		, m_Path(path)
+	{
+		m_RedShift = pSurface->format->Rshift;
+		m_GreenShift = pSurface->format->Gshift;
+		m_BlueShift = pSurface->format->Bshift;
+		m_AlphaShift = pSurface->format->Ashift;
+		m_HasAlpha = pSurface->format->Amask != 0;
+
+		BuildMipChain(pSurface, false);
 
 		// Create Texture2D Resource.
 		DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		D3D11_TEXTURE2D_DESC desc{};
-		desc.Width = m_pSurface->w;
-		desc.Height = m_pSurface->h;
+		desc.Width = pSurface->w;
+		desc.Height = pSurface->h;
 		desc.MipLevels = 1;
 		desc.ArraySize = 1;
 		desc.Format = format;
@@ -28,9 +40,9 @@ namespace dae
 		desc.MiscFlags = 0;
 
 		D3D11_SUBRESOURCE_DATA initData;
-		initData.pSysMem = m_pSurface->pixels;
-		initData.SysMemPitch = static_cast<UINT>(m_pSurface->pitch);
-		initData.SysMemSlicePitch = static_cast<UINT>(m_pSurface->h * m_pSurface->pitch);
+		initData.pSysMem = pSurface->pixels;
+		initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
+		initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
 
 		HRESULT hr = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
 
@@ -42,18 +54,14 @@ namespace dae
 
 		hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pSRV);
 
+		// The software side samples its own mip chain, the surface is no longer needed.
+		SDL_FreeSurface(pSurface);
 	}
 
 	Texture::~Texture()
 	{
 		m_pSRV->Release();
 		m_pResource->Release();
-
-		if (m_pSurface)
-		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
-		}
 	}
 
 
@@ -62,50 +70,186 @@ namespace dae
 		return m_pSRV;
 	}
 
-	ColorRGB Texture::Sample(const Vector2& uv) const
+	bool Texture::IsPowerOfTwo() const
+	{
+		const int width{ GetWidth() };
+		const int height{ GetHeight() };
+		return (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+	}
+
+	const Texture::MipLevel& Texture::AcquireLevel(int level) const
 	{
-		Uint8 r{}, g{}, b{};
+		level = std::min(level, GetMipCount() - 1);
+
+		const auto markSampled = [this](const MipLevel& mip)
+		{
+			// Only write when the value changes, so threads sampling the same level do not keep dirtying its cache line.
+			if (mip.lastSampledFrame.load(std::memory_order_relaxed) != m_CurrentFrame)
+			{
+				mip.lastSampledFrame.store(m_CurrentFrame, std::memory_order_relaxed);
+			}
+		};
+
+		markSampled(m_MipLevels[level]);
 
-		Vector2 UV;
+		// The smallest level is never evicted, so this always ends on a resident level.
+		while (!m_MipLevels[level].IsResident())
+		{
+			if (!m_MipLevels[level].isRequested.load(std::memory_order_relaxed))
+			{
+				m_MipLevels[level].isRequested.store(true, std::memory_order_relaxed);
+			}
+			++level;
+		}
 
-		// Wrapping.
-		const float integerPartX{ static_cast<float>(abs(static_cast<int>(uv.x))) };
-		const float integerPartY{ static_cast<float>(abs(static_cast<int>(uv.y))) };
+		markSampled(m_MipLevels[level]);
+		return m_MipLevels[level];
+	}
 
-		if (uv.x > 1.f)
+	size_t Texture::GetResidentBytes() const
+	{
+		size_t bytes{};
+		for (const auto& mip : m_MipLevels)
 		{
-			UV.x = uv.x - integerPartX;
+			bytes += mip.GetSizeInBytes();
 		}
-		else if (uv.x < 0.f)
+		return bytes;
+	}
+
+	bool Texture::CanEvict(int level) const
+	{
+		return !m_Path.empty() && level < GetMipCount() - 1 && m_MipLevels[level].IsResident();
+	}
+
+	void Texture::EvictLevel(int level)
+	{
+		assert(CanEvict(level));
+
+		// Swap with an empty vector to actually release the memory.
+		std::vector<uint32_t>{}.swap(m_MipLevels[level].texels);
+	}
+
+	int Texture::ReloadRequestedLevels()
+	{
+		int requestedCount{};
+		for (const auto& mip : m_MipLevels)
 		{
-			UV.x = uv.x + integerPartX;
+			if (mip.isRequested.load(std::memory_order_relaxed) && !mip.IsResident())
+			{
+				++requestedCount;
+			}
 		}
-		else
+
+		if (requestedCount == 0)
 		{
-			UV.x = uv.x;
+			return 0;
 		}
 
-		if (uv.y > 1.f)
+		SDL_Surface* pSurface{ IMG_Load(m_Path.c_str()) };
+		if (!pSurface)
 		{
-			UV.y = uv.y - integerPartY;
+			std::cout << "Texture: Failed to reload " << m_Path << '\n';
+			return 0;
 		}
-		else if (uv.y < 0.f)
+
+		BuildMipChain(pSurface, true);
+		SDL_FreeSurface(pSurface);
+
+		return requestedCount;
+	}
+
+	std::vector<uint32_t> Texture::Downsample(const std::vector<uint32_t>& texels, int width, int height)
+	{
+		const int halfWidth{ std::max(1, width / 2) };
+		const int halfHeight{ std::max(1, height / 2) };
+		std::vector<uint32_t> downsampled(static_cast<size_t>(halfWidth) * halfHeight);
+
+		// 2x2 box filter, every byte lane averaged separately so the channel order does not matter.
+		for (int y = 0; y < halfHeight; ++y)
 		{
-			UV.y = uv.y + integerPartY;
+			const int y0{ std::min(2 * y, height - 1) };
+			const int y1{ std::min(2 * y + 1, height - 1) };
+			for (int x = 0; x < halfWidth; ++x)
+			{
+				const int x0{ std::min(2 * x, width - 1) };
+				const int x1{ std::min(2 * x + 1, width - 1) };
+				const uint32_t p00{ texels[x0 + y0 * width] };
+				const uint32_t p10{ texels[x1 + y0 * width] };
+				const uint32_t p01{ texels[x0 + y1 * width] };
+				const uint32_t p11{ texels[x1 + y1 * width] };
+
+				uint32_t averaged{};
+				for (int shift = 0; shift < 32; shift += 8)
+				{
+					const uint32_t sum{ ((p00 >> shift) & 0xFF) + ((p10 >> shift) & 0xFF) + ((p01 >> shift) & 0xFF) + ((p11 >> shift) & 0xFF) };
+					averaged |= ((sum + 2) / 4) << shift;
+				}
+				downsampled[x + y * halfWidth] = averaged;
+			}
 		}
-		else
+
+		return downsampled;
+	}
+
+	int Texture::CalculateMipCount(int width, int height)
+	{
+		int count{ 1 };
+		while (width > 1 || height > 1)
 		{
-			UV.y = uv.y;
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+			++count;
 		}
+		return count;
+	}
 
-		const int x{ static_cast<int>(UV.x * m_pSurface->w) };
-		const int y{ static_cast<int>(UV.y * m_pSurface->h) };
+	void Texture::BuildMipChain(const SDL_Surface* pSurface, bool onlyRequested)
+	{
+		// Level 0, copied row by row since the surface pitch can be padded.
+		std::vector<uint32_t> previous(static_cast<size_t>(pSurface->w) * pSurface->h);
+		for (int y = 0; y < pSurface->h; ++y)
+		{
+			const uint32_t* pRow{ reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(pSurface->pixels) + y * pSurface->pitch) };
+			std::copy_n(pRow, pSurface->w, previous.begin() + static_cast<size_t>(y) * pSurface->w);
+		}
 
-		const Uint32 pixel{ m_pSurfacePixels[x + y * m_pSurface->w] };
+		int previousWidth{ pSurface->w };
+		int previousHeight{ pSurface->h };
 
-		SDL_GetRGB(pixel, m_pSurface->format, &r, &g, &b);
+		for (int level = 0; level < GetMipCount(); ++level)
+		{
+			MipLevel& mip{ m_MipLevels[level] };
+			const int width{ std::max(1, pSurface->w >> level) };
+			const int height{ std::max(1, pSurface->h >> level) };
+			std::vector<uint32_t> texels{};
+
+			if (level == 0)
+			{
+				texels = previous;
+			}
+			else
+			{
+				texels = Downsample(previous, previousWidth, previousHeight);
+				previous = texels;
+			}
+
+			previousWidth = width;
+			previousHeight = height;
+
+			mip.width = width;
+			mip.height = height;
+
+			if (!onlyRequested || (mip.isRequested.load(std::memory_order_relaxed) && !mip.IsResident()))
+			{
+				mip.texels = std::move(texels);
+				mip.lastSampledFrame.store(m_CurrentFrame, std::memory_order_relaxed);
+			}
+			mip.isRequested.store(false, std::memory_order_relaxed);
+		}
+	}
 
-		constexpr float remap{ 1 / 255.f };
-		return { r * remap, g * remap, b * remap };
+	ColorRGB Texture::Sample(const Vector2& uv) const
+	{
+		return Sampler<AddressMode::Wrap, FilterMode::Point>::Sample(*this, uv);
 	}
 }
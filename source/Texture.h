@@ -1,6 +1,8 @@
 #pragma once
 #include <SDL_surface.h>
 #include <string>
+#include <vector>
+#include <atomic>
 #include "ColorRGB.h"
 
 namespace dae
@@ -10,15 +12,81 @@ namespace dae
 	class Texture final
 	{
 	public:
+
+		// Software mip level, the texels are empty when the level is evicted.
+		struct MipLevel
+		{
+			int width{};
+			int height{};
+			std::vector<uint32_t> texels{};
+
+			mutable std::atomic<uint32_t> lastSampledFrame{};
+			mutable std::atomic<bool> isRequested{ false };
+
+			bool IsResident() const { return !texels.empty(); }
+			size_t GetSizeInBytes() const { return texels.size() * sizeof(uint32_t); }
+		};
+
 		Texture(const std::string& path, ID3D11Device* pDevice);
+		// Takes ownership of an already decoded surface (see AssetLoader).
+		// Without a path the mip levels can not be reloaded, so they are never evicted.
+		Texture(SDL_Surface* pSurface, ID3D11Device* pDevice, const std::string& path = {});
 		~Texture();
 
+		Texture(const Texture&) = delete;
+		Texture(Texture&&) noexcept = delete;
+		Texture& operator=(const Texture&) = delete;
+		Texture& operator=(Texture&&) noexcept = delete;
+
 		// DX
 		ID3D11ShaderResourceView* GetSRV() const;
 
 		// Software.
 		ColorRGB Sample(const Vector2& uv) const;
 
+		int GetWidth() const { return m_MipLevels.front().width; }
+		int GetHeight() const { return m_MipLevels.front().height; }
+		int GetMipCount() const { return static_cast<int>(m_MipLevels.size()); }
+		bool IsPowerOfTwo() const;
+
+		// Returns the requested level, or the closest coarser one that is resident.
+		// A missing level is flagged so the TextureManager reloads it at the end of the frame.
+		const MipLevel& AcquireLevel(int level) const;
+
+		ColorRGB GetTexel(const MipLevel& mip, int x, int y) const
+		{
+			const uint32_t pixel{ mip.texels[x + y * mip.width] };
+
+			constexpr float remap{ 1 / 255.f };
+			return { static_cast<float>((pixel >> m_RedShift) & 0xFF) * remap,
+				static_cast<float>((pixel >> m_GreenShift) & 0xFF) * remap,
+				static_cast<float>((pixel >> m_BlueShift) & 0xFF) * remap };
+		}
+
+		// 1 for formats without alpha.
+		float GetTexelAlpha(const MipLevel& mip, int x, int y) const
+		{
+			if (!m_HasAlpha)
+			{
+				return 1.f;
+			}
+
+			constexpr float remap{ 1 / 255.f };
+			return static_cast<float>((mip.texels[x + y * mip.width] >> m_AlphaShift) & 0xFF) * remap;
+		}
+
+		// Residency, only called by the TextureManager between frames.
+		const std::string& GetPath() const { return m_Path; }
+		const MipLevel& GetLevel(int level) const { return m_MipLevels[level]; }
+		size_t GetResidentBytes() const;
+		void SetCurrentFrame(uint32_t frame) { m_CurrentFrame = frame; }
+		bool CanEvict(int level) const;
+		void EvictLevel(int level);
+		int ReloadRequestedLevels();
+
+		// Halves both dimensions (down to 1) with a 2x2 box filter.
+		static std::vector<uint32_t> Downsample(const std::vector<uint32_t>& texels, int width, int height);
+
 	private:
 
 		// DX.
@@ -26,7 +94,20 @@ namespace dae
 		ID3D11ShaderResourceView* m_pSRV;
 
 		// Software.
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+		std::vector<MipLevel> m_MipLevels;
+		std::string m_Path;
+		uint32_t m_CurrentFrame{};
+
+		// Channel positions resolved from the surface format once, instead of SDL_GetRGB per texel.
+		uint8_t m_RedShift{};
+		uint8_t m_GreenShift{};
+		uint8_t m_BlueShift{};
+		uint8_t m_AlphaShift{};
+		bool m_HasAlpha{ false };
+
+		// Functions.
+
+		static int CalculateMipCount(int width, int height);
+		void BuildMipChain(const SDL_Surface* pSurface, bool onlyRequested);
 	};
-}
\ No newline at end of file
+}
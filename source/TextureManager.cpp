@@ -0,0 +1,141 @@
+#include "pch.h"
+#include "TextureManager.h"
+
+namespace dae
+{
+	TextureManager::TextureManager(ID3D11Device* pDevice, size_t budgetBytes)
+		: m_pDevice(pDevice)
+		, m_BudgetBytes(budgetBytes)
+	{
+	}
+
+	Texture* TextureManager::Load(const std::string& path)
+	{
+		const auto it = m_Textures.find(path);
+		if (it != m_Textures.end())
+		{
+			++m_Hits;
+			return it->second.get();
+		}
+
+		++m_Misses;
+		auto& pTexture = m_Textures[path];
+		pTexture = std::make_unique<Texture>(path, m_pDevice);
+		pTexture->SetCurrentFrame(m_CurrentFrame);
+
+		EvictToBudget();
+		return pTexture.get();
+	}
+
+	Texture* TextureManager::Add(const std::string& path, SDL_Surface* pSurface)
+	{
+		const auto it = m_Textures.find(path);
+		if (it != m_Textures.end())
+		{
+			++m_Hits;
+			SDL_FreeSurface(pSurface);
+			return it->second.get();
+		}
+
+		++m_Misses;
+		auto& pTexture = m_Textures[path];
+		pTexture = std::make_unique<Texture>(pSurface, m_pDevice, path);
+		pTexture->SetCurrentFrame(m_CurrentFrame);
+
+		EvictToBudget();
+		return pTexture.get();
+	}
+
+	void TextureManager::SetBudget(size_t budgetBytes)
+	{
+		m_BudgetBytes = budgetBytes;
+		EvictToBudget();
+	}
+
+	void TextureManager::EndFrame()
+	{
+		for (const auto& texture : m_Textures)
+		{
+			m_Reloads += texture.second->ReloadRequestedLevels();
+		}
+
+		++m_CurrentFrame;
+		for (const auto& texture : m_Textures)
+		{
+			texture.second->SetCurrentFrame(m_CurrentFrame);
+		}
+
+		EvictToBudget();
+	}
+
+	TextureManager::Stats TextureManager::GetStats() const
+	{
+		return { GetResidentBytes(), m_BudgetBytes, m_Hits, m_Misses, m_Evictions, m_Reloads };
+	}
+
+	void TextureManager::PrintStats() const
+	{
+		const Stats stats{ GetStats() };
+		constexpr float toMegaBytes{ 1.f / (1024.f * 1024.f) };
+
+		std::cout << "Textures: " << m_Textures.size()
+			<< " | Resident: " << static_cast<float>(stats.residentBytes) * toMegaBytes << " / " << static_cast<float>(stats.budgetBytes) * toMegaBytes << " MB"
+			<< " | Hits: " << stats.hits
+			<< " | Misses: " << stats.misses
+			<< " | Evictions: " << stats.evictions
+			<< " | Reloads: " << stats.reloads << '\n';
+	}
+
+	size_t TextureManager::GetResidentBytes() const
+	{
+		size_t bytes{};
+		for (const auto& texture : m_Textures)
+		{
+			bytes += texture.second->GetResidentBytes();
+		}
+		return bytes;
+	}
+
+	void TextureManager::EvictToBudget()
+	{
+		size_t residentBytes{ GetResidentBytes() };
+
+		while (residentBytes > m_BudgetBytes)
+		{
+			// Find the least recently sampled level over all textures.
+			Texture* pVictim{ nullptr };
+			int victimLevel{};
+			uint32_t oldestFrame{ UINT32_MAX };
+
+			for (const auto& texture : m_Textures)
+			{
+				for (int level = 0; level < texture.second->GetMipCount(); ++level)
+				{
+					if (!texture.second->CanEvict(level))
+					{
+						continue;
+					}
+
+					const Texture::MipLevel& mip{ texture.second->GetLevel(level) };
+					const uint32_t lastSampled{ mip.lastSampledFrame.load(std::memory_order_relaxed) };
+					if (lastSampled < oldestFrame)
+					{
+						pVictim = texture.second.get();
+						victimLevel = level;
+						oldestFrame = lastSampled;
+					}
+				}
+			}
+
+			if (!pVictim)
+			{
+				// Only the smallest levels or textures without a path are left.
+				return;
+			}
+
+			residentBytes -= pVictim->GetLevel(victimLevel).GetSizeInBytes();
+			pVictim->EvictLevel(victimLevel);
+			++m_Evictions;
+		}
+	}
+}
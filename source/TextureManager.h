@@ -0,0 +1,65 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include "Texture.h"
+
+namespace dae
+{
+	// Owns every texture, deduplicated by path.
+	// Keeps the software mip chains within a CPU memory budget by evicting the least recently sampled levels,
+	// levels that get sampled while evicted are reloaded from disk at the end of the frame.
+	class TextureManager final
+	{
+	public:
+
+		struct Stats
+		{
+			size_t residentBytes{};
+			size_t budgetBytes{};
+			uint64_t hits{};
+			uint64_t misses{};
+			uint64_t evictions{};
+			uint64_t reloads{};
+		};
+
+		static constexpr size_t DefaultBudgetBytes{ 256 * 1024 * 1024 };
+
+		explicit TextureManager(ID3D11Device* pDevice, size_t budgetBytes = DefaultBudgetBytes);
+		~TextureManager() = default;
+
+		TextureManager(const TextureManager&) = delete;
+		TextureManager(TextureManager&&) noexcept = delete;
+		TextureManager& operator=(const TextureManager&) = delete;
+		TextureManager& operator=(TextureManager&&) noexcept = delete;
+
+		Texture* Load(const std::string& path);
+		// Takes ownership of a surface decoded elsewhere (see AssetLoader), unless the path is already loaded.
+		Texture* Add(const std::string& path, SDL_Surface* pSurface);
+
+		void SetBudget(size_t budgetBytes);
+		// Call when no frame is being rendered: reloads requested levels and evicts down to the budget.
+		void EndFrame();
+
+		Stats GetStats() const;
+		void PrintStats() const;
+
+	private:
+
+		ID3D11Device* m_pDevice;
+		std::unordered_map<std::string, std::unique_ptr<Texture>> m_Textures{};
+
+		size_t m_BudgetBytes;
+		uint32_t m_CurrentFrame{};
+
+		uint64_t m_Hits{};
+		uint64_t m_Misses{};
+		uint64_t m_Evictions{};
+		uint64_t m_Reloads{};
+
+		// Functions.
+
+		size_t GetResidentBytes() const;
+		void EvictToBudget();
+	};
+}
@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "TileBinner.h"
+
+namespace dae
+{
+	TileBinner::TileBinner(int width, int height)
+	{
+		Resize(width, height);
+	}
+
+	void TileBinner::Resize(int width, int height)
+	{
+		if (width == m_Width && height == m_Height)
+		{
+			return;
+		}
+
+		m_Width = width;
+		m_Height = height;
+		m_TilesX = (width + TileSize - 1) / TileSize;
+		m_TilesY = (height + TileSize - 1) / TileSize;
+
+		// Shrinking keeps the bins past the new tile count alive, so growing back does not allocate them again.
+		m_Tiles.clear();
+		m_Tiles.reserve(static_cast<size_t>(m_TilesX) * m_TilesY);
+		for (int tileY = 0; tileY < m_TilesY; ++tileY)
+		{
+			for (int tileX = 0; tileX < m_TilesX; ++tileX)
+			{
+				m_Tiles.emplace_back(Tile{ tileX * TileSize, tileY * TileSize, std::min((tileX + 1) * TileSize, m_Width), std::min((tileY + 1) * TileSize, m_Height) });
+			}
+		}
+		if (m_Bins.size() < m_Tiles.size())
+		{
+			m_Bins.resize(m_Tiles.size());
+		}
+		Clear();
+	}
+
+	void TileBinner::Clear()
+	{
+		// Clearing keeps the capacity, so after the first frames binning no longer allocates.
+		for (auto& bin : m_Bins)
+		{
+			bin.clear();
+		}
+	}
+
+	void TileBinner::Bin(uint32_t triangle, int minX, int minY, int maxX, int maxY)
+	{
+		if (minX >= maxX || minY >= maxY)
+		{
+			return;
+		}
+
+		const int firstTileX{ std::clamp(minX / TileSize, 0, m_TilesX - 1) };
+		const int lastTileX{ std::clamp((maxX - 1) / TileSize, 0, m_TilesX - 1) };
+		const int firstTileY{ std::clamp(minY / TileSize, 0, m_TilesY - 1) };
+		const int lastTileY{ std::clamp((maxY - 1) / TileSize, 0, m_TilesY - 1) };
+
+		for (int tileY = firstTileY; tileY <= lastTileY; ++tileY)
+		{
+			for (int tileX = firstTileX; tileX <= lastTileX; ++tileX)
+			{
+				m_Bins[tileY * m_TilesX + tileX].emplace_back(triangle);
+			}
+		}
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+
+namespace dae
+{
+	// Screen rectangle, max is exclusive.
+	struct Tile
+	{
+		int minX{};
+		int minY{};
+		int maxX{};
+		int maxY{};
+	};
+
+	// Sorts triangles into the screen tiles their bounding box overlaps.
+	// Rasterizing tile by tile gives every tile to a single thread, so depth testing and blending need no synchronization,
+	// and a tile's pixels stay in cache while all of its triangles are drawn.
+	class TileBinner final
+	{
+	public:
+
+		static constexpr int TileSize{ 64 };
+
+		TileBinner(int width, int height);
+
+		// Re-tiles for a new raster size, the bins keep their capacity.
+		void Resize(int width, int height);
+
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+		int GetTileCount() const { return static_cast<int>(m_Tiles.size()); }
+		const Tile& GetTile(int tile) const { return m_Tiles[tile]; }
+
+		// Triangle indices in the order they were binned.
+		const std::vector<uint32_t>& GetTriangles(int tile) const { return m_Bins[tile]; }
+
+		void Clear();
+		// The bounding box is in raster space, max is exclusive like Tile.
+		void Bin(uint32_t triangle, int minX, int minY, int maxX, int maxY);
+
+	private:
+
+		int m_Width{};
+		int m_Height{};
+		int m_TilesX{};
+		int m_TilesY{};
+
+		std::vector<Tile> m_Tiles{};
+		std::vector<std::vector<uint32_t>> m_Bins{};
+	};
+}
@@ -1,6 +1,8 @@
 #include "pch.h"
 #include "VehicleEffect.h"
 
+#include <array>
+
 namespace dae
 {
 	VehicleEffect::VehicleEffect(ID3D11Device* pDevice, const std::wstring& assetFile)
@@ -30,16 +32,28 @@ namespace dae
 			std::wcout << L"m_pSpecularMapVariable not valid\n";
 		}
 
-		m_pLightDirection = m_pEffect->GetVariableByName("gLightDirection")->AsVector();
-		if (!m_pLightDirection->IsValid())
+		m_pLightCount = m_pEffect->GetVariableByName("gLightCount")->AsScalar();
+		if (!m_pLightCount->IsValid())
 		{
-			std::wcout << L"m_pLightDirection not valid\n";
+			std::wcout << L"m_pLightCount not valid\n";
 		}
 
-		m_pLightIntensity = m_pEffect->GetVariableByName("gLightIntensity")->AsScalar();
-		if (!m_pLightIntensity->IsValid())
+		m_pLightPositions = m_pEffect->GetVariableByName("gLightPositions")->AsVector();
+		if (!m_pLightPositions->IsValid())
 		{
-			std::wcout << L"m_pLightIntensity not valid\n";
+			std::wcout << L"m_pLightPositions not valid\n";
+		}
+
+		m_pLightDirections = m_pEffect->GetVariableByName("gLightDirections")->AsVector();
+		if (!m_pLightDirections->IsValid())
+		{
+			std::wcout << L"m_pLightDirections not valid\n";
+		}
+
+		m_pLightParameters = m_pEffect->GetVariableByName("gLightParameters")->AsVector();
+		if (!m_pLightParameters->IsValid())
+		{
+			std::wcout << L"m_pLightParameters not valid\n";
 		}
 	}
 
@@ -98,17 +112,41 @@ namespace dae
 		}
 	}
 
-	void VehicleEffect::SetLight(Lights* pLight)
+	void VehicleEffect::SetLights(const std::vector<Lights*>& pLights)
 	{
-		if (m_pLightDirection)
+		// Packed like the arrays of PosCol3D.fx:
+		// position + range, direction + type, intensity + inner and outer cone cosines.
+		const int lightCount{ std::min(static_cast<int>(pLights.size()), MaxLights) };
+		std::array<Vector4, MaxLights> positions{};
+		std::array<Vector4, MaxLights> directions{};
+		std::array<Vector4, MaxLights> parameters{};
+
+		for (int i = 0; i < lightCount; ++i)
+		{
+			const Lights* pLight{ pLights[i] };
+			positions[i] = Vector4{ pLight->GetPosition(), pLight->GetRange() };
+			directions[i] = Vector4{ pLight->GetDirection(), static_cast<float>(pLight->GetType()) };
+			parameters[i] = Vector4{ pLight->GetlightIntensity(), pLight->GetInnerConeCos(), pLight->GetOuterConeCos(), 0.f };
+		}
+
+		if (m_pLightCount)
+		{
+			m_pLightCount->SetInt(lightCount);
+		}
+
+		if (m_pLightPositions)
+		{
+			m_pLightPositions->SetFloatVectorArray(&positions[0].x, 0, lightCount);
+		}
+
+		if (m_pLightDirections)
 		{
-			const auto floatArr = Vector4{ pLight->GetDirection(), 1.f };
-			m_pLightDirection->SetFloatVector(&floatArr.x);
+			m_pLightDirections->SetFloatVectorArray(&directions[0].x, 0, lightCount);
 		}
 
-		if (m_pLightIntensity)
+		if (m_pLightParameters)
 		{
-			m_pLightIntensity->SetFloat(pLight->GetlightIntensity());
+			m_pLightParameters->SetFloatVectorArray(&parameters[0].x, 0, lightCount);
 		}
 	}
 }
@@ -20,7 +20,10 @@ namespace dae
 		void SetSpecularMap(Texture* pSpecularTexture) override;
 		void SetGlossMap(Texture* pGlossTexture) override;
 
-		void SetLight(Lights* pLight) override;
+		// Same limit as MAX_LIGHTS in PosCol3D.fx.
+		static constexpr int MaxLights{ 8 };
+
+		void SetLights(const std::vector<Lights*>& pLights) override;
 
 	private:
 
@@ -29,8 +32,10 @@ namespace dae
 		ID3DX11EffectShaderResourceVariable* m_pSpecularMapVariable;
 		ID3DX11EffectShaderResourceVariable* m_pGlossMapVariable;
 
-		ID3DX11EffectVectorVariable* m_pLightDirection;
-		ID3DX11EffectScalarVariable* m_pLightIntensity;
+		ID3DX11EffectScalarVariable* m_pLightCount;
+		ID3DX11EffectVectorVariable* m_pLightPositions;
+		ID3DX11EffectVectorVariable* m_pLightDirections;
+		ID3DX11EffectVectorVariable* m_pLightParameters;
 
 	};
 }
\ No newline at end of file
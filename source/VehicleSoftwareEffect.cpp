@@ -0,0 +1,375 @@
+#include "pch.h"
+#include "VehicleSoftwareEffect.h"
+
+#include "BRDFs.h"
+#include "Sampler.h"
+#include "ShadowMap.h"
+#include "ClusteredLights.h"
+#include "SoftwareRaster.h"
+
+namespace dae
+{
+	// All vehicle maps are power of two, wrapped like the point sampler of PosCol3D.fx.
+	using VehicleSampler = Sampler<AddressMode::Wrap, FilterMode::Point, TextureSize::PowerOfTwo>;
+
+	VehicleSoftwareEffect::VehicleSoftwareEffect()
+		: m_SpecularLut(SpecularShininess)
+	{
+	}
+
+	void VehicleSoftwareEffect::TransformVertices(Mesh& mesh, const Camera& camera) const
+	{
+		SoftwareRaster::TransformVertices<SoftwareRaster::StandardVertexShader>(mesh, camera);
+	}
+
+	void VehicleSoftwareEffect::DrawTile(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const
+	{
+		(this->*m_pDrawTile)(state, triangles, tileTriangles, tile);
+	}
+
+	template<DepthFormat Format, Culling CullMode, bool BoundingBox, bool DepthVisualized, bool NormalMap, VehicleSoftwareEffect::ShadingModes Shading, SpecularAccuracy Accuracy>
+	void VehicleSoftwareEffect::DrawTileWith(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const
+	{
+		const PixelShader<NormalMap, Shading, Accuracy> pixelShader{ *this, state };
+		for (const uint32_t triangle : tileTriangles)
+		{
+			SoftwareRaster::RasterizeOpaque<PixelShader<NormalMap, Shading, Accuracy>, BoundingBox, DepthVisualized, CullMode, Format>(state, triangles[triangle], tile, pixelShader);
+		}
+	}
+
+	template<size_t Index>
+	constexpr VehicleSoftwareEffect::DrawTileFunction VehicleSoftwareEffect::GetDrawTile()
+	{
+		// Index = (depthFormat * cullingModes + culling) * views + view, with a shaded view = (normalMap * shadingModes + shading) * accuracies + accuracy.
+		constexpr size_t view{ Index % ViewCount };
+		constexpr auto culling{ static_cast<Culling>((Index / ViewCount) % CullingModeCount) };
+		constexpr auto depthFormat{ static_cast<DepthFormat>(Index / (ViewCount * CullingModeCount)) };
+		constexpr bool boundingBox{ view == BoundingBoxView };
+		constexpr bool depthVisualized{ view == DepthView };
+
+		// The visualizations take the first shading specialization, they never call it.
+		constexpr size_t shadedView{ view < ShadedViewCount ? view : 0 };
+		constexpr auto accuracy{ static_cast<SpecularAccuracy>(shadedView % SpecularAccuracyCount) };
+		constexpr auto shading{ static_cast<ShadingModes>((shadedView / SpecularAccuracyCount) % ShadingModeCount) };
+		constexpr bool normalMap{ shadedView / (SpecularAccuracyCount * ShadingModeCount) == 1 };
+
+		return &VehicleSoftwareEffect::DrawTileWith<depthFormat, culling, boundingBox, depthVisualized, normalMap, shading, accuracy>;
+	}
+
+	template<size_t... Indices>
+	constexpr std::array<VehicleSoftwareEffect::DrawTileFunction, sizeof...(Indices)> VehicleSoftwareEffect::MakeDrawTileTable(std::index_sequence<Indices...>)
+	{
+		return { GetDrawTile<Indices>()... };
+	}
+
+	void VehicleSoftwareEffect::BeginFrame(const RasterState& state)
+	{
+		UpdateAnisotropyBudget();
+
+		// The toggles only change between frames, so the specialization is picked once here instead of per pixel.
+		static constexpr auto drawTiles{ MakeDrawTileTable(std::make_index_sequence<DrawTileCount>{}) };
+
+		size_t view{ static_cast<size_t>(m_ToggleNormalMap) };
+		view = view * ShadingModeCount + static_cast<size_t>(m_ShadingMode);
+		view = view * SpecularAccuracyCount + static_cast<size_t>(m_SpecularAccuracy);
+		if (state.isBoundingBox)
+		{
+			view = BoundingBoxView;
+		}
+		else if (state.isDepthVisualized)
+		{
+			view = DepthView;
+		}
+
+		size_t index{ static_cast<size_t>(state.depthFormat) };
+		index = index * CullingModeCount + static_cast<size_t>(state.cullMode);
+		index = index * ViewCount + view;
+
+		m_pDrawTile = drawTiles[index];
+	}
+
+	template<bool NormalMap, VehicleSoftwareEffect::ShadingModes Shading, SpecularAccuracy Accuracy>
+	ColorRGB VehicleSoftwareEffect::PixelShading(const RasterState& state, const Vertex_Out& v, const Vector3& worldPosition, const Vector2& uvDdx, const Vector2& uvDdy) const
+	{
+		constexpr ColorRGB ambient{ 0.025f, 0.025f, 0.025f };
+		constexpr bool usesDiffuse{ Shading == ShadingModes::Combined || Shading == ShadingModes::Diffuse };
+		constexpr bool usesSpecular{ Shading == ShadingModes::Combined || Shading == ShadingModes::Specular };
+
+		Vector3 tangentSpaceVector = v.normal;
+
+		if constexpr (NormalMap)
+		{
+			//// Calculate Binormal.
+			const Vector3 binormal{ Vector3::Cross(v.normal, v.tangent).Normalized() };
+
+			//// Calculate Tangent space Matrix.
+			const Matrix tangentSpaceMatrix{ v.tangent, binormal, v.normal, Vector3::Zero };
+
+			//// Calculate Normal according to the Normal Map.
+			const ColorRGB normalMapCol{ (2 * SampleVehicle(*m_pNormalVehicle, v.uv, uvDdx, uvDdy)) - colors::White };
+			Vector3 normalMapVector{ normalMapCol.r, normalMapCol.g, normalMapCol.b };
+			normalMapVector /= 255.f;
+			tangentSpaceVector = tangentSpaceMatrix.TransformVector(normalMapVector).Normalized();
+		}
+
+		// Only the maps the mode shows are fetched, once for all lights.
+		ColorRGB diffuse{};
+		if constexpr (usesDiffuse)
+		{
+			diffuse = SampleDiffuse(v, uvDdx, uvDdy);
+		}
+
+		ColorRGB specularColor{};
+		float gloss{};
+		if constexpr (usesSpecular)
+		{
+			specularColor = SampleVehicle(*m_pSpecularVehicle, v.uv, uvDdx, uvDdy);
+			gloss = SampleVehicle(*m_pGlossVehicle, v.uv, uvDdx, uvDdy).r;
+		}
+
+		ColorRGB finalColor{};
+		if constexpr (Shading == ShadingModes::Combined)
+		{
+			finalColor = ambient;
+		}
+
+		// Only the lights of the pixel's cluster.
+		const LightBuffer& lights{ state.pLights->GetLights() };
+		const int cluster{ state.pLights->FindCluster(static_cast<int>(v.position.x), static_cast<int>(v.position.y), v.position.w) };
+		state.pLights->CountShadedPixel(cluster);
+
+		for (const uint32_t lightIndex : state.pLights->GetClusterLights(cluster))
+		{
+			const Vector3 direction{ lights.directionX[lightIndex], lights.directionY[lightIndex], lights.directionZ[lightIndex] };
+			Vector3 lightDirection{ direction };
+			float falloff{ 1.f };
+			if (lights.types[lightIndex] != LightType::Directional)
+			{
+				// Reaches 0 at the range, so culling by the range sphere leaves no seams.
+				const Vector3 toPixel{ worldPosition - Vector3{ lights.positionX[lightIndex], lights.positionY[lightIndex], lights.positionZ[lightIndex] } };
+				const float distance{ toPixel.Magnitude() };
+				if (distance >= lights.ranges[lightIndex])
+				{
+					continue;
+				}
+
+				lightDirection = toPixel / std::max(distance, 1e-6f);
+				falloff = Lights::GetDistanceAttenuation(distance, lights.ranges[lightIndex]);
+
+				if (lights.types[lightIndex] == LightType::Spot)
+				{
+					falloff *= Lights::GetConeAttenuation(Vector3::Dot(lightDirection, direction), lights.innerConeCos[lightIndex], lights.outerConeCos[lightIndex]);
+				}
+			}
+
+			if constexpr (Shading != ShadingModes::ObservedArea)
+			{
+				if (lightIndex == state.shadowLightIndex)
+				{
+					falloff *= state.pShadowMap->SampleVisibility(worldPosition);
+				}
+			}
+
+			const float lightIntensity{ lights.intensities[lightIndex] * falloff };
+			const float lambertCosineLaw{ GetLambertCosine(tangentSpaceVector, lightDirection) };
+
+			if constexpr (Shading == ShadingModes::ObservedArea)
+			{
+				finalColor += ColorRGB{ 1, 1, 1 } * lambertCosineLaw;
+			}
+			else if constexpr (Shading == ShadingModes::Diffuse)
+			{
+				finalColor += (diffuse * lambertCosineLaw * lightIntensity);
+			}
+			else if constexpr (Shading == ShadingModes::Specular)
+			{
+				finalColor += specularColor * (SpecularLobe<Accuracy>(BRDF::PhongCosine(lightDirection, v.viewDirection, tangentSpaceVector), gloss) * falloff);
+			}
+			else
+			{
+				const ColorRGB specular{ specularColor * (SpecularLobe<Accuracy>(BRDF::PhongCosine(lightDirection, v.viewDirection, tangentSpaceVector), gloss) * falloff) };
+				finalColor += (diffuse * lightIntensity + specular) * lambertCosineLaw;
+			}
+		}
+
+		return finalColor;
+	}
+
+	ColorRGB VehicleSoftwareEffect::SampleDiffuse(const Vertex_Out& v, const Vector2& uvDdx, const Vector2& uvDdy) const
+	{
+		const ColorRGB diffuse{ m_UseVirtualTexture ? m_pVirtualDiffuse->Sample(v.uv, static_cast<int>(CalculateLod(m_pVirtualDiffuse->GetWidth(), m_pVirtualDiffuse->GetHeight(), uvDdx, uvDdy) + 0.5f)) : SampleVehicle(*m_pDiffuseVehicle, v.uv, uvDdx, uvDdy) };
+		return BRDF::Lambert(1.0f, diffuse);
+	}
+
+	template<SpecularAccuracy Accuracy>
+	float VehicleSoftwareEffect::SpecularLobe(float cosAlpha, float gloss) const
+	{
+		if constexpr (Accuracy == SpecularAccuracy::Exact)
+		{
+			return SpecularPow::Exact(cosAlpha, SpecularShininess * gloss);
+		}
+		else if constexpr (Accuracy == SpecularAccuracy::Fast)
+		{
+			return SpecularPow::Fast(cosAlpha, SpecularShininess * gloss);
+		}
+		else
+		{
+			return m_SpecularLut.Sample(cosAlpha, gloss);
+		}
+	}
+
+	ColorRGB VehicleSoftwareEffect::SampleVehicle(const Texture& texture, const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy) const
+	{
+		switch (m_FilteringMode)
+		{
+		case Filtering::Linear:
+		{
+			const int level{ static_cast<int>(CalculateLod(texture.GetWidth(), texture.GetHeight(), uvDdx, uvDdy) + 0.5f) };
+			return Sampler<AddressMode::Wrap, FilterMode::Bilinear, TextureSize::PowerOfTwo>::Sample(texture, uv, level);
+		}
+		case Filtering::Anisotropic:
+		{
+			const int maxTaps{ m_AnisotropyBudget.isEnabled ? std::min(m_MaxAnisotropy, m_AnisotropyBudget.tapCap) : m_MaxAnisotropy };
+			return AnisotropicSampler<AddressMode::Wrap, TextureSize::PowerOfTwo>::Sample(texture, uv, uvDdx, uvDdy, maxTaps);
+		}
+		default:
+			return VehicleSampler::Sample(texture, uv);
+		}
+	}
+
+	void VehicleSoftwareEffect::UpdateAnisotropyBudget()
+	{
+		const uint64_t counter{ SDL_GetPerformanceCounter() };
+		const float frameTime{ static_cast<float>(counter - m_AnisotropyBudget.lastFrameCounter) / static_cast<float>(SDL_GetPerformanceFrequency()) };
+		const bool isFirstFrame{ m_AnisotropyBudget.lastFrameCounter == 0 };
+		m_AnisotropyBudget.lastFrameCounter = counter;
+
+		if (!m_AnisotropyBudget.isEnabled || m_FilteringMode != Filtering::Anisotropic || isFirstFrame)
+		{
+			return;
+		}
+
+		// Halve right away when over budget, double only after a run of frames with clear headroom to avoid oscillating.
+		constexpr int framesBeforeRaise{ 30 };
+		constexpr float headroom{ 0.8f };
+		if (frameTime > m_AnisotropyBudget.targetFrameTime && m_AnisotropyBudget.tapCap > 1)
+		{
+			m_AnisotropyBudget.tapCap /= 2;
+			m_AnisotropyBudget.framesUnderTarget = 0;
+			std::cout << "Anisotropy Budget: " << m_AnisotropyBudget.tapCap << "x.\n";
+		}
+		else if (frameTime < m_AnisotropyBudget.targetFrameTime * headroom && m_AnisotropyBudget.tapCap < m_MaxAnisotropy)
+		{
+			if (++m_AnisotropyBudget.framesUnderTarget >= framesBeforeRaise)
+			{
+				m_AnisotropyBudget.tapCap = std::min(m_AnisotropyBudget.tapCap * 2, m_MaxAnisotropy);
+				m_AnisotropyBudget.framesUnderTarget = 0;
+				std::cout << "Anisotropy Budget: " << m_AnisotropyBudget.tapCap << "x.\n";
+			}
+		}
+		else
+		{
+			m_AnisotropyBudget.framesUnderTarget = 0;
+		}
+	}
+
+	float VehicleSoftwareEffect::GetLambertCosine(const Vector3& normal, const Vector3& lightDirection) const
+	{
+		const float lambertCosine = std::max(0.f, Vector3::Dot(normal, -lightDirection.Normalized()));
+		return lambertCosine;
+	}
+
+	void VehicleSoftwareEffect::SetTextures(Texture* pDiffuse, Texture* pNormal, Texture* pGloss, Texture* pSpecular)
+	{
+		m_pDiffuseVehicle = pDiffuse;
+		m_pNormalVehicle = pNormal;
+		m_pGlossVehicle = pGloss;
+		m_pSpecularVehicle = pSpecular;
+
+		assert(m_pDiffuseVehicle->IsPowerOfTwo() && m_pNormalVehicle->IsPowerOfTwo() && m_pGlossVehicle->IsPowerOfTwo() && m_pSpecularVehicle->IsPowerOfTwo());
+	}
+
+	void VehicleSoftwareEffect::SetVirtualDiffuse(const VirtualTexture* pVirtualDiffuse)
+	{
+		m_pVirtualDiffuse = pVirtualDiffuse;
+	}
+
+	void VehicleSoftwareEffect::ToggleNormalMap()
+	{
+		m_ToggleNormalMap = !m_ToggleNormalMap;
+		std::cout << (m_ToggleNormalMap ? "Normal Map ON.\n" : "Normal Map OFF.\n");
+	}
+
+	void VehicleSoftwareEffect::ToggleVirtualTexture()
+	{
+		if (!m_pVirtualDiffuse || !m_pVirtualDiffuse->IsValid())
+		{
+			std::cout << "No Virtual Texture loaded.\n";
+			return;
+		}
+
+		m_UseVirtualTexture = !m_UseVirtualTexture;
+		std::cout << (m_UseVirtualTexture ? "Virtual Texture Diffuse ON.\n" : "Virtual Texture Diffuse OFF.\n");
+	}
+
+	void VehicleSoftwareEffect::CycleFilteringMode()
+	{
+		int count{ static_cast<int>(m_FilteringMode) };
+		count++;
+		if (count > 2)
+		{
+			count = 0;
+		}
+		m_FilteringMode = static_cast<Filtering>(count);
+
+		const std::array<std::string, 3> filteringNames{ "Filtering Mode: Point", "Filtering Mode: Linear", "Filtering Mode: Anisotropic" };
+		std::cout << filteringNames.at(count);
+		if (m_FilteringMode == Filtering::Anisotropic)
+		{
+			std::cout << " " << m_MaxAnisotropy << "x";
+		}
+		std::cout << '\n';
+	}
+
+	void VehicleSoftwareEffect::SetMaxAnisotropy(int maxAnisotropy)
+	{
+		m_MaxAnisotropy = std::clamp(maxAnisotropy, 2, AnisotropicSampler<AddressMode::Wrap>::MaxTaps);
+		m_AnisotropyBudget.tapCap = m_MaxAnisotropy;
+	}
+
+	void VehicleSoftwareEffect::ToggleAnisotropyBudget()
+	{
+		m_AnisotropyBudget.isEnabled = !m_AnisotropyBudget.isEnabled;
+		m_AnisotropyBudget.tapCap = m_MaxAnisotropy;
+		m_AnisotropyBudget.framesUnderTarget = 0;
+		std::cout << (m_AnisotropyBudget.isEnabled ? "Anisotropy Frame Budget ON.\n" : "Anisotropy Frame Budget OFF.\n");
+	}
+
+	void VehicleSoftwareEffect::CycleSpecularAccuracy()
+	{
+		m_SpecularAccuracy = static_cast<SpecularAccuracy>((static_cast<int>(m_SpecularAccuracy) + 1) % SpecularAccuracyCount);
+
+		const std::array<std::string, SpecularAccuracyCount> accuracyNames{ "Specular Accuracy: Exact.", "Specular Accuracy: Fast.", "Specular Accuracy: Lookup Table." };
+		std::cout << accuracyNames.at(static_cast<int>(m_SpecularAccuracy)) << std::endl;
+	}
+
+	void VehicleSoftwareEffect::PrintSpecularErrorReport() const
+	{
+		SpecularPow::PrintErrorReport(m_SpecularLut);
+	}
+
+	void VehicleSoftwareEffect::CycleShadingMode()
+	{
+		int count{ static_cast<int>(m_ShadingMode) };
+		count++;
+		if (count > 3)
+		{
+			count = 0;
+		}
+		const auto castEnum = static_cast<ShadingModes>(count);
+		m_ShadingMode = castEnum;
+
+		const std::array<std::string, 4> shadingNames{ "Shading Mode: Combined.", "Shading Mode: Observed Area.", "Shading Mode: Diffuse.", "Shading Mode: Specular." };
+		std::cout << shadingNames.at(count) << std::endl;
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <array>
+#include <utility>
+#include "SoftwareEffect.h"
+#include "Texture.h"
+#include "SpecularPow.h"
+#include "VirtualTexture.h"
+
+namespace dae
+{
+	// Software version of PosCol3D.fx: normal mapped Phong, lit by the clustered lights and shadowed by the shadow map.
+	class VehicleSoftwareEffect final : public SoftwareEffect
+	{
+	public:
+
+		VehicleSoftwareEffect();
+		~VehicleSoftwareEffect() override = default;
+
+		VehicleSoftwareEffect(const VehicleSoftwareEffect&) = delete;
+		VehicleSoftwareEffect(VehicleSoftwareEffect&&) noexcept = delete;
+		VehicleSoftwareEffect& operator=(const VehicleSoftwareEffect&) = delete;
+		VehicleSoftwareEffect& operator=(VehicleSoftwareEffect&&) noexcept = delete;
+
+		bool IsTransparent() const override { return false; }
+		void BeginFrame(const RasterState& state) override;
+		void TransformVertices(Mesh& mesh, const Camera& camera) const override;
+		void DrawTile(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const override;
+
+		void SetTextures(Texture* pDiffuse, Texture* pNormal, Texture* pGloss, Texture* pSpecular);
+		void SetVirtualDiffuse(const VirtualTexture* pVirtualDiffuse);
+		void CycleShadingMode();
+		void ToggleNormalMap();
+		void ToggleVirtualTexture();
+		void CycleFilteringMode();
+		void SetMaxAnisotropy(int maxAnisotropy);
+		int GetMaxAnisotropy() const { return m_MaxAnisotropy; }
+		void ToggleAnisotropyBudget();
+		void CycleSpecularAccuracy();
+		void PrintSpecularErrorReport() const;
+
+	private:
+
+		enum class ShadingModes
+		{
+			Combined, ObservedArea, Diffuse, Specular
+		};
+
+		enum class Filtering
+		{
+			Point, Linear, Anisotropic
+		};
+
+		// The pixel stage handed to SoftwareRaster::RasterizeOpaque, one type per shading specialization.
+		template<bool NormalMap, ShadingModes Shading, SpecularAccuracy Accuracy>
+		struct PixelShader
+		{
+			static constexpr bool UsesTangent{ NormalMap };
+
+			const VehicleSoftwareEffect& effect;
+			const RasterState& state;
+
+			bool NeedsDerivatives() const
+			{
+				// Textures are only fetched when the shading mode uses them, so only then are their derivatives needed.
+				constexpr bool samplesTextures{ NormalMap || Shading != ShadingModes::ObservedArea };
+				return samplesTextures && (effect.m_FilteringMode != Filtering::Point || effect.m_UseVirtualTexture);
+			}
+
+			ColorRGB Shade(const PixelQuad& quad, int lane) const
+			{
+				// UV differences to the neighbour pixels of the quad, for mip selection and anisotropic filtering.
+				return effect.PixelShading<NormalMap, Shading, Accuracy>(state, quad.fragments[lane], quad.worldPositions[lane],
+					quad.Ddx(&Vertex_Out::uv, lane), quad.Ddy(&Vertex_Out::uv, lane));
+			}
+		};
+
+		// Every combination of the raster and shading toggles is its own specialization of DrawTileWith,
+		// BeginFrame picks one from a table so the pixels never branch on a mode.
+		using DrawTileFunction = void (VehicleSoftwareEffect::*)(const RasterState&, std::span<const RasterTriangle>, std::span<const uint32_t>, const Tile&) const;
+		static constexpr size_t DepthFormatCount{ 4 };
+		static constexpr size_t CullingModeCount{ 3 };
+		static constexpr size_t ShadingModeCount{ 4 };
+		static constexpr size_t SpecularAccuracyCount{ 3 };
+		// What a tile shows: one view per shading specialization, then the depth and the bounding box visualization,
+		// which shade nothing and so need no specialization per shading toggle.
+		static constexpr size_t ShadedViewCount{ 2 * ShadingModeCount * SpecularAccuracyCount };
+		static constexpr size_t DepthView{ ShadedViewCount };
+		static constexpr size_t BoundingBoxView{ ShadedViewCount + 1 };
+		static constexpr size_t ViewCount{ ShadedViewCount + 2 };
+		static constexpr size_t DrawTileCount{ DepthFormatCount * CullingModeCount * ViewCount };
+
+		// The gloss map scales the Phong exponent up to this.
+		static constexpr float SpecularShininess{ 25.f };
+
+		// Lowers the anisotropic tap count while the frame time is over the target, raises it again once there is headroom.
+		struct AnisotropyBudget
+		{
+			bool isEnabled{ false };
+			float targetFrameTime{ 1.f / 30.f };
+			int tapCap{ 16 };
+			int framesUnderTarget{};
+			uint64_t lastFrameCounter{};
+		};
+
+		bool m_ToggleNormalMap{ true };
+		bool m_UseVirtualTexture{ false };
+
+		Texture* m_pDiffuseVehicle{ nullptr };
+		Texture* m_pNormalVehicle{ nullptr };
+		Texture* m_pGlossVehicle{ nullptr };
+		Texture* m_pSpecularVehicle{ nullptr };
+		const VirtualTexture* m_pVirtualDiffuse{ nullptr };
+
+		ShadingModes m_ShadingMode{ ShadingModes::Combined };
+		Filtering m_FilteringMode{ Filtering::Point };
+		int m_MaxAnisotropy{ 16 };
+		AnisotropyBudget m_AnisotropyBudget{};
+		SpecularAccuracy m_SpecularAccuracy{ SpecularAccuracy::Exact };
+		SpecularLut m_SpecularLut;
+
+		DrawTileFunction m_pDrawTile{ nullptr };
+
+		// Functions.
+
+		template<DepthFormat Format, Culling CullMode, bool BoundingBox, bool DepthVisualized, bool NormalMap, ShadingModes Shading, SpecularAccuracy Accuracy>
+		void DrawTileWith(const RasterState& state, std::span<const RasterTriangle> triangles, std::span<const uint32_t> tileTriangles, const Tile& tile) const;
+		template<size_t Index>
+		static constexpr DrawTileFunction GetDrawTile();
+		template<size_t... Indices>
+		static constexpr std::array<DrawTileFunction, sizeof...(Indices)> MakeDrawTileTable(std::index_sequence<Indices...>);
+		template<bool NormalMap, ShadingModes Shading, SpecularAccuracy Accuracy>
+		ColorRGB PixelShading(const RasterState& state, const Vertex_Out& v, const Vector3& worldPosition, const Vector2& uvDdx, const Vector2& uvDdy) const;
+		ColorRGB SampleDiffuse(const Vertex_Out& v, const Vector2& uvDdx, const Vector2& uvDdy) const;
+		template<SpecularAccuracy Accuracy>
+		float SpecularLobe(float cosAlpha, float gloss) const;
+		ColorRGB SampleVehicle(const Texture& texture, const Vector2& uv, const Vector2& uvDdx, const Vector2& uvDdy) const;
+		void UpdateAnisotropyBudget();
+		float GetLambertCosine(const Vector3& normal, const Vector3& lightDirection) const;
+	};
+}
@@ -0,0 +1,362 @@
+#include "pch.h"
+#include "VirtualTexture.h"
+#include "Texture.h"
+#include "Vector2.h"
+
+namespace dae
+{
+	bool VirtualTexture::BuildTileFile(const std::string& imagePath, const std::string& tileFilePath, int pageSize)
+	{
+		assert((pageSize & (pageSize - 1)) == 0);
+
+		SDL_Surface* pSurface{ IMG_Load(imagePath.c_str()) };
+		if (!pSurface)
+		{
+			std::cout << "VirtualTexture: Failed to load " << imagePath << '\n';
+			return false;
+		}
+
+		std::ofstream file(tileFilePath, std::ios::binary);
+		if (!file)
+		{
+			std::cout << "VirtualTexture: Failed to create " << tileFilePath << '\n';
+			SDL_FreeSurface(pSurface);
+			return false;
+		}
+
+		int width{ pSurface->w };
+		int height{ pSurface->h };
+
+		std::vector<uint32_t> texels(static_cast<size_t>(width) * height);
+		for (int y = 0; y < height; ++y)
+		{
+			const uint32_t* pRow{ reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(pSurface->pixels) + y * pSurface->pitch) };
+			std::copy_n(pRow, width, texels.begin() + static_cast<size_t>(y) * width);
+		}
+
+		TileFileHeader header{};
+		header.magic = TileFileMagic;
+		header.width = static_cast<uint32_t>(width);
+		header.height = static_cast<uint32_t>(height);
+		header.pageSize = static_cast<uint32_t>(pageSize);
+		header.redShift = pSurface->format->Rshift;
+		header.greenShift = pSurface->format->Gshift;
+		header.blueShift = pSurface->format->Bshift;
+		header.mipCount = 1;
+		for (int w = width, h = height; w > 1 || h > 1; w = std::max(1, w / 2), h = std::max(1, h / 2))
+		{
+			++header.mipCount;
+		}
+
+		SDL_FreeSurface(pSurface);
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(TileFileHeader));
+
+		// Pages are stored level by level, row by row. Edge pages are padded by clamping.
+		std::vector<uint32_t> page(static_cast<size_t>(pageSize) * pageSize);
+		for (uint32_t level = 0; level < header.mipCount; ++level)
+		{
+			const int pagesX{ (width + pageSize - 1) / pageSize };
+			const int pagesY{ (height + pageSize - 1) / pageSize };
+
+			for (int pageY = 0; pageY < pagesY; ++pageY)
+			{
+				for (int pageX = 0; pageX < pagesX; ++pageX)
+				{
+					for (int y = 0; y < pageSize; ++y)
+					{
+						const int sourceY{ std::min(pageY * pageSize + y, height - 1) };
+						for (int x = 0; x < pageSize; ++x)
+						{
+							const int sourceX{ std::min(pageX * pageSize + x, width - 1) };
+							page[x + y * pageSize] = texels[sourceX + sourceY * width];
+						}
+					}
+					file.write(reinterpret_cast<const char*>(page.data()), page.size() * sizeof(uint32_t));
+				}
+			}
+
+			texels = Texture::Downsample(texels, width, height);
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+
+		return static_cast<bool>(file);
+	}
+
+	VirtualTexture::VirtualTexture(const std::string& tileFilePath, int physicalPageCount)
+		: m_File(tileFilePath, std::ios::binary)
+	{
+		if (!m_File.read(reinterpret_cast<char*>(&m_Header), sizeof(TileFileHeader)) || m_Header.magic != TileFileMagic)
+		{
+			std::cout << "VirtualTexture: " << tileFilePath << " is not a valid tile file\n";
+			return;
+		}
+
+		const int pageSize{ static_cast<int>(m_Header.pageSize) };
+		m_PageMask = pageSize - 1;
+		m_PageTexelCount = pageSize * pageSize;
+		while ((1 << m_PageShift) < pageSize)
+		{
+			++m_PageShift;
+		}
+
+		// Page table layout.
+		int tailCount{};
+		int width{ static_cast<int>(m_Header.width) };
+		int height{ static_cast<int>(m_Header.height) };
+		for (uint32_t level = 0; level < m_Header.mipCount; ++level)
+		{
+			Level mip{ width, height, (width + pageSize - 1) / pageSize, (height + pageSize - 1) / pageSize, m_VirtualPageCount };
+			m_VirtualPageCount += mip.pagesX * mip.pagesY;
+			m_Levels.push_back(mip);
+
+			if (mip.pagesX == 1 && mip.pagesY == 1)
+			{
+				++tailCount;
+			}
+
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+
+		m_PageTable.assign(m_VirtualPageCount, -1);
+		m_IsPending.assign(m_VirtualPageCount, 0);
+		m_Feedback = std::make_unique<std::atomic<uint8_t>[]>(m_VirtualPageCount);
+
+		// The physical cache needs room for the pinned tail plus the pages streamed in each frame.
+		physicalPageCount = std::max(physicalPageCount, tailCount + MaxPageInsPerFrame);
+		m_PhysicalTexels.resize(static_cast<size_t>(physicalPageCount) * m_PageTexelCount);
+		m_PhysicalPages.resize(physicalPageCount);
+
+		// Pin the levels that fit in a single page, they are the fallback for every missing page.
+		std::vector<uint32_t> texels{};
+		for (const Level& mip : m_Levels)
+		{
+			if (mip.pagesX == 1 && mip.pagesY == 1)
+			{
+				ReadPage(mip.firstPage, texels);
+				MapPage(mip.firstPage, texels, true);
+			}
+		}
+
+		m_StreamingThread = std::thread(&VirtualTexture::StreamingLoop, this);
+	}
+
+	VirtualTexture::~VirtualTexture()
+	{
+		if (!m_StreamingThread.joinable())
+		{
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_StreamingMutex);
+			m_IsStopping = true;
+		}
+		m_StreamingCondition.notify_all();
+		m_StreamingThread.join();
+	}
+
+	ColorRGB VirtualTexture::Sample(const Vector2& uv, int level) const
+	{
+		// Wrap.
+		const float u{ uv.x - std::floor(uv.x) };
+		const float v{ uv.y - std::floor(uv.y) };
+
+		for (level = std::clamp(level, 0, GetMipCount() - 1); ; ++level)
+		{
+			const Level& mip{ m_Levels[level] };
+			const int x{ std::min(static_cast<int>(u * static_cast<float>(mip.width)), mip.width - 1) };
+			const int y{ std::min(static_cast<int>(v * static_cast<float>(mip.height)), mip.height - 1) };
+			const int virtualPage{ mip.firstPage + (y >> m_PageShift) * mip.pagesX + (x >> m_PageShift) };
+
+			// Request the page. The flag stays set until Update reads the feedback back, so only the first sample of a page each frame stores.
+			if (!m_Feedback[virtualPage].load(std::memory_order_relaxed))
+			{
+				m_Feedback[virtualPage].store(1, std::memory_order_relaxed);
+			}
+
+			const int physicalPage{ m_PageTable[virtualPage] };
+			if (physicalPage >= 0)
+			{
+				const uint32_t pixel{ m_PhysicalTexels[static_cast<size_t>(physicalPage) * m_PageTexelCount + ((y & m_PageMask) << m_PageShift) + (x & m_PageMask)] };
+
+				constexpr float remap{ 1 / 255.f };
+				return { static_cast<float>((pixel >> m_Header.redShift) & 0xFF) * remap,
+					static_cast<float>((pixel >> m_Header.greenShift) & 0xFF) * remap,
+					static_cast<float>((pixel >> m_Header.blueShift) & 0xFF) * remap };
+			}
+		}
+	}
+
+	void VirtualTexture::Update()
+	{
+		if (!IsValid())
+		{
+			return;
+		}
+
+		// Read back the feedback of the frame that just finished.
+		std::vector<int> requests{};
+		for (int page = 0; page < m_VirtualPageCount; ++page)
+		{
+			if (!m_Feedback[page].load(std::memory_order_relaxed))
+			{
+				continue;
+			}
+			m_Feedback[page].store(0, std::memory_order_relaxed);
+
+			const int physicalPage{ m_PageTable[page] };
+			if (physicalPage >= 0)
+			{
+				m_PhysicalPages[physicalPage].lastUsedFrame = m_CurrentFrame;
+			}
+			else if (!m_IsPending[page])
+			{
+				requests.push_back(page);
+			}
+		}
+
+		// Map the pages the streaming thread finished.
+		std::vector<LoadedPage> loadedPages{};
+		{
+			std::unique_lock<std::mutex> lock(m_StreamingMutex);
+			loadedPages.swap(m_LoadedPages);
+		}
+
+		for (const auto& page : loadedPages)
+		{
+			m_IsPending[page.virtualPage] = 0;
+			MapPage(page.virtualPage, page.texels, false);
+		}
+
+		// Pages are numbered level by level, so the highest numbers are the coarsest pages.
+		// Stream those first, they improve the fallback for the most pixels.
+		std::reverse(requests.begin(), requests.end());
+		if (requests.size() > MaxPageInsPerFrame)
+		{
+			requests.resize(MaxPageInsPerFrame);
+		}
+
+		if (!requests.empty())
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_StreamingMutex);
+				for (const int page : requests)
+				{
+					m_IsPending[page] = 1;
+					m_Requests.push_back(page);
+				}
+			}
+			m_StreamingCondition.notify_one();
+		}
+
+		++m_CurrentFrame;
+	}
+
+	void VirtualTexture::PrintStats() const
+	{
+		int residentPages{};
+		for (const auto& page : m_PhysicalPages)
+		{
+			if (page.virtualPage >= 0)
+			{
+				++residentPages;
+			}
+		}
+
+		std::cout << "Virtual Texture: " << GetWidth() << "x" << GetHeight()
+			<< " | Resident Pages: " << residentPages << " / " << m_PhysicalPages.size() << " (of " << m_VirtualPageCount << " virtual)"
+			<< " | Page Ins: " << m_PageIns
+			<< " | Page Evictions: " << m_PageEvictions << '\n';
+	}
+
+	void VirtualTexture::ReadPage(int virtualPage, std::vector<uint32_t>& texels)
+	{
+		texels.resize(m_PageTexelCount);
+
+		const std::streamoff pageBytes{ static_cast<std::streamoff>(m_PageTexelCount) * static_cast<std::streamoff>(sizeof(uint32_t)) };
+		m_File.seekg(static_cast<std::streamoff>(sizeof(TileFileHeader)) + virtualPage * pageBytes);
+		m_File.read(reinterpret_cast<char*>(texels.data()), pageBytes);
+	}
+
+	void VirtualTexture::MapPage(int virtualPage, const std::vector<uint32_t>& texels, bool isPinned)
+	{
+		const int physicalPage{ FindPhysicalPage() };
+		if (physicalPage < 0)
+		{
+			// Everything is in use this frame, the page gets requested again if it is still needed.
+			return;
+		}
+
+		PhysicalPage& page{ m_PhysicalPages[physicalPage] };
+		if (page.virtualPage >= 0)
+		{
+			m_PageTable[page.virtualPage] = -1;
+			++m_PageEvictions;
+		}
+
+		std::copy(texels.begin(), texels.end(), m_PhysicalTexels.begin() + static_cast<size_t>(physicalPage) * m_PageTexelCount);
+		page.virtualPage = virtualPage;
+		page.lastUsedFrame = m_CurrentFrame;
+		page.isPinned = isPinned;
+		m_PageTable[virtualPage] = physicalPage;
+
+		if (!isPinned)
+		{
+			++m_PageIns;
+		}
+	}
+
+	int VirtualTexture::FindPhysicalPage() const
+	{
+		int leastRecentlyUsed{ -1 };
+		for (int i = 0; i < static_cast<int>(m_PhysicalPages.size()); ++i)
+		{
+			const PhysicalPage& page{ m_PhysicalPages[i] };
+			if (page.virtualPage < 0)
+			{
+				return i;
+			}
+
+			// Pages used by the frame that just finished stay.
+			if (page.isPinned || page.lastUsedFrame >= m_CurrentFrame)
+			{
+				continue;
+			}
+
+			if (leastRecentlyUsed < 0 || page.lastUsedFrame < m_PhysicalPages[leastRecentlyUsed].lastUsedFrame)
+			{
+				leastRecentlyUsed = i;
+			}
+		}
+		return leastRecentlyUsed;
+	}
+
+	void VirtualTexture::StreamingLoop()
+	{
+		while (true)
+		{
+			int virtualPage{};
+			{
+				std::unique_lock<std::mutex> lock(m_StreamingMutex);
+				m_StreamingCondition.wait(lock, [this]() { return m_IsStopping || !m_Requests.empty(); });
+
+				if (m_IsStopping)
+				{
+					return;
+				}
+
+				virtualPage = m_Requests.front();
+				m_Requests.pop_front();
+			}
+
+			LoadedPage page{ virtualPage };
+			ReadPage(virtualPage, page.texels);
+
+			std::unique_lock<std::mutex> lock(m_StreamingMutex);
+			m_LoadedPages.push_back(std::move(page));
+		}
+	}
+}
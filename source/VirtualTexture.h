@@ -0,0 +1,131 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include "ColorRGB.h"
+
+namespace dae
+{
+	struct Vector2;
+
+	// Software virtual texture for images too large to keep in memory.
+	// The mip chain is stored in a tiled file on disk and split into fixed size pages,
+	// only the pages the visible pixels sample are streamed into a fixed size physical page cache.
+	// A sample whose page is not resident falls back to the closest coarser resident level,
+	// the levels that fit in a single page are always resident so there is always something to sample.
+	class VirtualTexture final
+	{
+	public:
+
+		static constexpr int DefaultPageSize{ 128 };
+		static constexpr int DefaultPhysicalPageCount{ 64 };
+		static constexpr int MaxPageInsPerFrame{ 16 };
+
+		// Converts an image into the tiled file format, pageSize has to be a power of two.
+		static bool BuildTileFile(const std::string& imagePath, const std::string& tileFilePath, int pageSize = DefaultPageSize);
+
+		explicit VirtualTexture(const std::string& tileFilePath, int physicalPageCount = DefaultPhysicalPageCount);
+		~VirtualTexture();
+
+		VirtualTexture(const VirtualTexture&) = delete;
+		VirtualTexture(VirtualTexture&&) noexcept = delete;
+		VirtualTexture& operator=(const VirtualTexture&) = delete;
+		VirtualTexture& operator=(VirtualTexture&&) noexcept = delete;
+
+		bool IsValid() const { return !m_Levels.empty(); }
+		int GetWidth() const { return m_Levels.front().width; }
+		int GetHeight() const { return m_Levels.front().height; }
+		int GetMipCount() const { return static_cast<int>(m_Levels.size()); }
+
+		// Point sampled with wrap addressing, safe to call from the render threads.
+		ColorRGB Sample(const Vector2& uv, int level = 0) const;
+
+		// Call when no frame is being rendered: maps the pages the streaming thread finished
+		// and queues the pages the last frame asked for.
+		void Update();
+
+		void PrintStats() const;
+
+	private:
+
+		struct TileFileHeader
+		{
+			uint32_t magic{};
+			uint32_t width{};
+			uint32_t height{};
+			uint32_t pageSize{};
+			uint32_t mipCount{};
+			uint8_t redShift{};
+			uint8_t greenShift{};
+			uint8_t blueShift{};
+			uint8_t padding{};
+		};
+
+		struct Level
+		{
+			int width{};
+			int height{};
+			int pagesX{};
+			int pagesY{};
+			int firstPage{};
+		};
+
+		struct PhysicalPage
+		{
+			int virtualPage{ -1 };
+			uint32_t lastUsedFrame{};
+			bool isPinned{ false };
+		};
+
+		struct LoadedPage
+		{
+			int virtualPage{};
+			std::vector<uint32_t> texels{};
+		};
+
+		static constexpr uint32_t TileFileMagic{ 0x31545644 }; // "DVT1"
+
+		std::ifstream m_File;
+		TileFileHeader m_Header{};
+		int m_PageShift{};
+		int m_PageMask{};
+		int m_PageTexelCount{};
+
+		std::vector<Level> m_Levels{};
+		int m_VirtualPageCount{};
+
+		// Virtual page -> physical page, -1 when not resident. Only written between frames.
+		std::vector<int> m_PageTable{};
+		// Set by the render threads for every page a sample touched.
+		std::unique_ptr<std::atomic<uint8_t>[]> m_Feedback{};
+		std::vector<uint8_t> m_IsPending{};
+
+		std::vector<uint32_t> m_PhysicalTexels{};
+		std::vector<PhysicalPage> m_PhysicalPages{};
+		uint32_t m_CurrentFrame{};
+
+		// Streaming.
+		std::thread m_StreamingThread{};
+		std::mutex m_StreamingMutex{};
+		std::condition_variable m_StreamingCondition{};
+		std::deque<int> m_Requests{};
+		std::vector<LoadedPage> m_LoadedPages{};
+		bool m_IsStopping{ false };
+
+		uint64_t m_PageIns{};
+		uint64_t m_PageEvictions{};
+
+		// Functions.
+
+		void ReadPage(int virtualPage, std::vector<uint32_t>& texels);
+		void MapPage(int virtualPage, const std::vector<uint32_t>& texels, bool isPinned);
+		int FindPhysicalPage() const;
+		void StreamingLoop();
+	};
+}
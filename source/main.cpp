@@ -6,6 +6,7 @@
 
 #undef main
 #include "Renderer.h"
+#include "JobSystem.h"
 
 using namespace dae;
 
@@ -17,21 +18,44 @@ void ShutDown(SDL_Window* pWindow)
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	// Software job system: --workers <count> and --pin-threads. Window size: --width <pixels> and --height <pixels>.
+	int workerCount{ JobSystem::GetDefaultWorkerCount() };
+	bool pinThreads{ false };
+	int width{ 640 };
+	int height{ 480 };
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument{ args[i] };
+		if (argument == "--workers" && i + 1 < argc)
+		{
+			workerCount = std::atoi(args[++i]);
+		}
+		else if (argument == "--width" && i + 1 < argc)
+		{
+			width = std::max(std::atoi(args[++i]), 1);
+		}
+		else if (argument == "--height" && i + 1 < argc)
+		{
+			height = std::max(std::atoi(args[++i]), 1);
+		}
+		else if (argument == "--pin-threads")
+		{
+			pinThreads = true;
+		}
+	}
+	if (workerCount != JobSystem::GetDefaultWorkerCount() || pinThreads)
+	{
+		JobSystem::GetInstance().Configure(workerCount, pinThreads);
+	}
 
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
 
-	const uint32_t width = 640;
-	const uint32_t height = 480;
-
 	SDL_Window* pWindow = SDL_CreateWindow(
 		"DirectX - *** Nevin Amarendranath (2DAE07) ***",
 		SDL_WINDOWPOS_UNDEFINED,
 		SDL_WINDOWPOS_UNDEFINED,
-		width, height, 0);
+		width, height, SDL_WINDOW_RESIZABLE);
 
 	if (!pWindow)
 		return 1;
@@ -56,6 +80,12 @@ int main(int argc, char* args[])
 			case SDL_QUIT:
 				isLooping = false;
 				break;
+			case SDL_WINDOWEVENT:
+				if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+				{
+					pRenderer->Resize(e.window.data1, e.window.data2);
+				}
+				break;
 			case SDL_KEYUP:
 				switch (e.key.keysym.sym)
 				{
@@ -89,8 +119,42 @@ int main(int argc, char* args[])
 				case SDLK_F10:
 					pRenderer->ToggleUniformBg();
 					break;
+				case SDLK_v:
+					pRenderer->ToggleVirtualTexture();
+					break;
+				case SDLK_a:
+					pRenderer->CycleMaxAnisotropy();
+					break;
+				case SDLK_b:
+					pRenderer->ToggleAnisotropyBudget();
+					break;
+				case SDLK_p:
+					pRenderer->CycleSpecularAccuracy();
+					break;
+				case SDLK_h:
+					pRenderer->ToggleShadows();
+					break;
+				case SDLK_r:
+					pRenderer->CycleShadingRateMode();
+					break;
+				case SDLK_l:
+					pRenderer->CycleFramesInFlight();
+					break;
+				case SDLK_m:
+					pRenderer->TogglePresentMode();
+					break;
+				case SDLK_c:
+					pRenderer->ToggleZeroCopyPresent();
+					break;
+				case SDLK_g:
+					pRenderer->ToggleDynamicResolution();
+					break;
+				case SDLK_z:
+					pRenderer->CycleDepthFormat();
+					break;
 				case SDLK_F11:
 					isDisplayFPS = !isDisplayFPS;
+					pRenderer->SetStatsEnabled(isDisplayFPS);
 					std::cout << (isDisplayFPS ? "Toggle Print FPS ON.\n" : "Toggle Print FPS OFF.\n");
 					break;
 				}
@@ -114,6 +178,7 @@ int main(int argc, char* args[])
 			if (isDisplayFPS)
 			{
 				std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+				pRenderer->PrintStats();
 			}
 		}
 	}